@@ -0,0 +1,362 @@
+/*
+ * avrutil.hpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * C++ counterpart of the pin functionality macros in avrutil.h: pins
+ * are types, groups of pins are folded at compile time into one set
+ * and one clear mask per port, so the code generated is what one would
+ * write by hand (sbi/cbi for single pins, one read-modify-write or one
+ * out per port for groups) without port_optimize_declare() and without
+ * relying on the optimizer to drop runtime flags.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+
+#ifndef _AVRUTIL_HPP_
+#define _AVRUTIL_HPP_
+
+/*
+Needs C++11 (avr-g++ -std=gnu++11, see the .cpp.o rule in Makefile-avr).
+Do not include avrutil.h in the same C++ file, its typedef of bool is C
+only.
+
+Usage:
+typedef avr::Pin<avr::PortA, 3, avr::ActiveHigh> Function1;
+typedef avr::Pin<avr::PortA, 6, avr::ActiveLow>  Function2;
+typedef avr::Pin<avr::PortB, 0>                  Led; // active high
+
+Function1::set();             // sbi PORTA, 3
+Function2::set();             // cbi PORTA, 6 (active low)
+Led::output();                // sbi DDRB, 0
+if (Function2::get())         // sbic PINA, 6
+	...
+
+avr::write_pins<avr::Set<Function1>, avr::Clr<Function2>, avr::Set<Led> >();
+	// PORTA |= _BV(3) | _BV(6); PORTB |= _BV(0), i.e. one access per port
+
+typedef avr::Pins<Function1, Function2> Group;
+Group::set();                 // both active, one PORTA update
+Group::output();
+if (Group::all_active())      // one masked compare per port
+	...
+
+write_pins's operations are Set<Pin>, Clr<Pin> (logic values, polarity
+applied) and Output<Pin>, Input<Pin> (direction). As in write_pins_dir,
+inputs are switched first, then the values written, then outputs.
+
+All masks and register addresses are template arguments: a block with
+one pin on a port turns into a single sbi/cbi, a block that specifies
+all 8 bits of a port into a single out, anything else into one
+in/ori/andi/out sequence per port (make check-avr checks the first two
+on test/pins.cpp). A pin that is both set and cleared in one block does
+not compile.
+*/
+
+#include <avr/io.h>
+#include <stdint.h>
+
+namespace avr {
+
+enum Polarity { ActiveLow = 0, ActiveHigh = 1 };
+
+template <class A, class B> struct same { static constexpr bool value = false; };
+template <class A> struct same<A, A> { static constexpr bool value = true; };
+
+/*
+A port is three register addresses (data space, as constants), so that
+every access below has the address in the instruction. The avr-libc
+register macros expand through _SFR_IO8/_SFR_MEM8 to an lvalue; here
+they are expanded with those two giving the address instead.
+*/
+#pragma push_macro("_SFR_IO8")
+#pragma push_macro("_SFR_MEM8")
+#undef _SFR_IO8
+#undef _SFR_MEM8
+#define _SFR_IO8(addr) ((addr) + __SFR_OFFSET)
+#define _SFR_MEM8(addr) (addr)
+
+#define _AVRUTIL_PORT(letter) \
+struct Port##letter { \
+	static constexpr uint16_t port = PORT##letter, ddr = DDR##letter, pin = PIN##letter; \
+};
+
+#ifdef PORTA
+_AVRUTIL_PORT(A)
+#endif
+#ifdef PORTB
+_AVRUTIL_PORT(B)
+#endif
+#ifdef PORTC
+_AVRUTIL_PORT(C)
+#endif
+#ifdef PORTD
+_AVRUTIL_PORT(D)
+#endif
+#ifdef PORTE
+_AVRUTIL_PORT(E)
+#endif
+#ifdef PORTF
+_AVRUTIL_PORT(F)
+#endif
+#undef _AVRUTIL_PORT
+
+#pragma pop_macro("_SFR_MEM8")
+#pragma pop_macro("_SFR_IO8")
+
+/* the register at a constant address: sbi/cbi/sbic/in/out reach the
+   low I/O ones directly */
+template <uint16_t addr>
+__attribute__((always_inline)) static inline volatile uint8_t &reg()
+{
+	return *(volatile uint8_t *)addr;
+}
+
+/* one register update, the masks decide the instructions */
+template <uint8_t set, uint8_t clr, uint16_t addr>
+__attribute__((always_inline)) static inline void reg_write()
+{
+	volatile uint8_t &r = reg<addr>();
+	static_assert(!(set & clr), "pin both set and cleared");
+	if (!set && !clr)
+		return;
+	if ((set | clr) == 0xff) /* all bits are specified, no need to know prev val */
+		r = set;
+	else if (!clr)
+		r |= set;
+	else if (!set)
+		r &= (uint8_t)~clr;
+	else
+		r = (r | set) & (uint8_t)~clr;
+}
+
+template <class Port, uint8_t n, Polarity pol = ActiveHigh>
+struct Pin {
+	static_assert(n < 8, "pin number out of range");
+	typedef Port port_t;
+	static constexpr uint8_t mask = 1 << n;
+	/* PORT bits to set / clear to make the pin active */
+	static constexpr uint8_t on_set = pol ? mask : 0;
+	static constexpr uint8_t on_clr = pol ? 0 : mask;
+
+	__attribute__((always_inline)) static inline void set_absolute() { reg<Port::port>() |= mask; }
+	__attribute__((always_inline)) static inline void clr_absolute() { reg<Port::port>() &= (uint8_t)~mask; }
+	__attribute__((always_inline)) static inline void set() { if (pol) set_absolute(); else clr_absolute(); }
+	__attribute__((always_inline)) static inline void clr() { if (pol) clr_absolute(); else set_absolute(); }
+	__attribute__((always_inline)) static inline void write(bool active) { if (active) set(); else clr(); }
+	__attribute__((always_inline)) static inline void toggle() { reg<Port::port>() ^= mask; }
+	__attribute__((always_inline)) static inline void output() { reg<Port::ddr>() |= mask; }
+	__attribute__((always_inline)) static inline void input() { reg<Port::ddr>() &= (uint8_t)~mask; }
+	__attribute__((always_inline)) static inline bool get_absolute() { return reg<Port::pin>() & mask; }
+	__attribute__((always_inline)) static inline bool get() { return pol ? get_absolute() : !get_absolute(); }
+};
+
+/* write_pins operations: PORT bits to set and clear, DDR bits to set and clear */
+template <class P> struct Set {
+	typedef typename P::port_t port_t;
+	static constexpr uint8_t set = P::on_set, clr = P::on_clr, out = 0, in = 0;
+};
+template <class P> struct Clr {
+	typedef typename P::port_t port_t;
+	static constexpr uint8_t set = P::on_clr, clr = P::on_set, out = 0, in = 0;
+};
+template <class P> struct Output {
+	typedef typename P::port_t port_t;
+	static constexpr uint8_t set = 0, clr = 0, out = P::mask, in = 0;
+};
+template <class P> struct Input {
+	typedef typename P::port_t port_t;
+	static constexpr uint8_t set = 0, clr = 0, out = 0, in = P::mask;
+};
+
+/* fold the masks of the operations on one port */
+template <class Port> constexpr uint8_t set_bits() { return 0; }
+template <class Port, class Op, class... Ops> constexpr uint8_t set_bits()
+{
+	return (same<Port, typename Op::port_t>::value ? Op::set : 0) | set_bits<Port, Ops...>();
+}
+template <class Port> constexpr uint8_t clr_bits() { return 0; }
+template <class Port, class Op, class... Ops> constexpr uint8_t clr_bits()
+{
+	return (same<Port, typename Op::port_t>::value ? Op::clr : 0) | clr_bits<Port, Ops...>();
+}
+template <class Port> constexpr uint8_t out_bits() { return 0; }
+template <class Port, class Op, class... Ops> constexpr uint8_t out_bits()
+{
+	return (same<Port, typename Op::port_t>::value ? Op::out : 0) | out_bits<Port, Ops...>();
+}
+template <class Port> constexpr uint8_t in_bits() { return 0; }
+template <class Port, class Op, class... Ops> constexpr uint8_t in_bits()
+{
+	return (same<Port, typename Op::port_t>::value ? Op::in : 0) | in_bits<Port, Ops...>();
+}
+
+template <class Port, class... Ops>
+__attribute__((always_inline)) static inline void port_inputs()
+{
+	reg_write<0, in_bits<Port, Ops...>(), Port::ddr>();
+}
+template <class Port, class... Ops>
+__attribute__((always_inline)) static inline void port_values()
+{
+	reg_write<set_bits<Port, Ops...>(), clr_bits<Port, Ops...>(), Port::port>();
+}
+template <class Port, class... Ops>
+__attribute__((always_inline)) static inline void port_outputs()
+{
+	reg_write<out_bits<Port, Ops...>(), 0, Port::ddr>();
+}
+
+#ifdef PORTA
+#define _AVRUTIL_EACH_A(step) step<PortA, Ops...>();
+#else
+#define _AVRUTIL_EACH_A(step)
+#endif
+#ifdef PORTB
+#define _AVRUTIL_EACH_B(step) step<PortB, Ops...>();
+#else
+#define _AVRUTIL_EACH_B(step)
+#endif
+#ifdef PORTC
+#define _AVRUTIL_EACH_C(step) step<PortC, Ops...>();
+#else
+#define _AVRUTIL_EACH_C(step)
+#endif
+#ifdef PORTD
+#define _AVRUTIL_EACH_D(step) step<PortD, Ops...>();
+#else
+#define _AVRUTIL_EACH_D(step)
+#endif
+#ifdef PORTE
+#define _AVRUTIL_EACH_E(step) step<PortE, Ops...>();
+#else
+#define _AVRUTIL_EACH_E(step)
+#endif
+#ifdef PORTF
+#define _AVRUTIL_EACH_F(step) step<PortF, Ops...>();
+#else
+#define _AVRUTIL_EACH_F(step)
+#endif
+#define _AVRUTIL_EACH(step) \
+	_AVRUTIL_EACH_A(step) _AVRUTIL_EACH_B(step) _AVRUTIL_EACH_C(step) \
+	_AVRUTIL_EACH_D(step) _AVRUTIL_EACH_E(step) _AVRUTIL_EACH_F(step)
+
+/* set inputs, write ports, set outputs; ports not named are not touched */
+template <class... Ops>
+__attribute__((always_inline)) static inline void write_pins()
+{
+	_AVRUTIL_EACH(port_inputs)
+	_AVRUTIL_EACH(port_values)
+	_AVRUTIL_EACH(port_outputs)
+}
+
+/* group test on one port: all pins named at the wanted PORT/PIN level */
+template <class Port, class... Ops>
+__attribute__((always_inline)) static inline bool port_match()
+{
+	constexpr uint8_t mask = set_bits<Port, Ops...>() | clr_bits<Port, Ops...>();
+	return !mask || (reg<Port::pin>() & mask) == set_bits<Port, Ops...>();
+}
+template <class Port, class... Ops>
+__attribute__((always_inline)) static inline bool port_any()
+{
+	constexpr uint8_t mask = set_bits<Port, Ops...>() | clr_bits<Port, Ops...>();
+	return mask && (reg<Port::pin>() & mask) != clr_bits<Port, Ops...>();
+}
+
+#ifdef PORTA
+#define _AVRUTIL_ALL_A(test) test<PortA, Set<Ps>...>() &&
+#define _AVRUTIL_ANY_A(test) test<PortA, Set<Ps>...>() ||
+#else
+#define _AVRUTIL_ALL_A(test)
+#define _AVRUTIL_ANY_A(test)
+#endif
+#ifdef PORTB
+#define _AVRUTIL_ALL_B(test) test<PortB, Set<Ps>...>() &&
+#define _AVRUTIL_ANY_B(test) test<PortB, Set<Ps>...>() ||
+#else
+#define _AVRUTIL_ALL_B(test)
+#define _AVRUTIL_ANY_B(test)
+#endif
+#ifdef PORTC
+#define _AVRUTIL_ALL_C(test) test<PortC, Set<Ps>...>() &&
+#define _AVRUTIL_ANY_C(test) test<PortC, Set<Ps>...>() ||
+#else
+#define _AVRUTIL_ALL_C(test)
+#define _AVRUTIL_ANY_C(test)
+#endif
+#ifdef PORTD
+#define _AVRUTIL_ALL_D(test) test<PortD, Set<Ps>...>() &&
+#define _AVRUTIL_ANY_D(test) test<PortD, Set<Ps>...>() ||
+#else
+#define _AVRUTIL_ALL_D(test)
+#define _AVRUTIL_ANY_D(test)
+#endif
+#ifdef PORTE
+#define _AVRUTIL_ALL_E(test) test<PortE, Set<Ps>...>() &&
+#define _AVRUTIL_ANY_E(test) test<PortE, Set<Ps>...>() ||
+#else
+#define _AVRUTIL_ALL_E(test)
+#define _AVRUTIL_ANY_E(test)
+#endif
+#ifdef PORTF
+#define _AVRUTIL_ALL_F(test) test<PortF, Set<Ps>...>() &&
+#define _AVRUTIL_ANY_F(test) test<PortF, Set<Ps>...>() ||
+#else
+#define _AVRUTIL_ALL_F(test)
+#define _AVRUTIL_ANY_F(test)
+#endif
+
+template <class... Ps>
+struct Pins {
+	__attribute__((always_inline)) static inline void set() { write_pins<Set<Ps>...>(); }
+	__attribute__((always_inline)) static inline void clr() { write_pins<Clr<Ps>...>(); }
+	__attribute__((always_inline)) static inline void output() { write_pins<Output<Ps>...>(); }
+	__attribute__((always_inline)) static inline void input() { write_pins<Input<Ps>...>(); }
+	__attribute__((always_inline)) static inline bool all_active()
+	{
+		return _AVRUTIL_ALL_A(port_match) _AVRUTIL_ALL_B(port_match) _AVRUTIL_ALL_C(port_match)
+			_AVRUTIL_ALL_D(port_match) _AVRUTIL_ALL_E(port_match) _AVRUTIL_ALL_F(port_match) true;
+	}
+	__attribute__((always_inline)) static inline bool any_active()
+	{
+		return _AVRUTIL_ANY_A(port_any) _AVRUTIL_ANY_B(port_any) _AVRUTIL_ANY_C(port_any)
+			_AVRUTIL_ANY_D(port_any) _AVRUTIL_ANY_E(port_any) _AVRUTIL_ANY_F(port_any) false;
+	}
+};
+
+} /* namespace avr */
+
+#undef _AVRUTIL_EACH
+#undef _AVRUTIL_EACH_A
+#undef _AVRUTIL_EACH_B
+#undef _AVRUTIL_EACH_C
+#undef _AVRUTIL_EACH_D
+#undef _AVRUTIL_EACH_E
+#undef _AVRUTIL_EACH_F
+#undef _AVRUTIL_ALL_A
+#undef _AVRUTIL_ALL_B
+#undef _AVRUTIL_ALL_C
+#undef _AVRUTIL_ALL_D
+#undef _AVRUTIL_ALL_E
+#undef _AVRUTIL_ALL_F
+#undef _AVRUTIL_ANY_A
+#undef _AVRUTIL_ANY_B
+#undef _AVRUTIL_ANY_C
+#undef _AVRUTIL_ANY_D
+#undef _AVRUTIL_ANY_E
+#undef _AVRUTIL_ANY_F
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ * boot.c
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Serial bootloader for the 2kB boot section (make boot bootflash bootfuse),
+ * host side: tools/bootload.py
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+
+/*
+Protocol on UART 0, 8N1, little-endian words, CRCs are CRC-16/XMODEM:
+  '?'                            -> 'T' pagesize:16 apppages:16
+  'P' page:16 data[pagesize] crc:16 -> '=' identical, not written
+                                       '.' accepted, being written
+                                       '!' bad crc or page number
+  'C' pages:16 crc:16            -> 'K' flash matches, 'E' it does not
+  'G'                            -> 'G', then start the application, if
+                                    the last 'C' answered 'K' and no page
+                                    was written since; 'E' otherwise
+A page is acknowledged before it is erased and written, so the host can
+send the next one meanwhile; the receive ring holds it until we are done.
+A gap of more than BOOT_GAP_MS inside a frame drops the frame silently
+and goes back to waiting for a command, so a lost byte costs the host a
+resend instead of the rest of the frame being taken for commands.
+With no '?' within BOOT_WAIT_MS of reset, the application is started if
+there is one.
+*/
+
+#define SERIAL_UARTS 1 /* UART 0 only, the boot section is small */
+#define MAIN
+#include "avrutil.h"
+#include <avr/boot.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+#include "dev/serial.h"
+
+#ifndef BOOT_ADDR
+#error BOOT_ADDR comes from BOOTADDR in the Makefile, with the BOOTSZ fuses
+#endif
+#ifndef BOOT_BAUD
+#define BOOT_BAUD 500000
+#endif
+#ifndef BOOT_WAIT_MS
+#define BOOT_WAIT_MS 1000
+#endif
+#ifndef BOOT_GAP_MS
+#define BOOT_GAP_MS 10 /* the host resends after 1s */
+#endif
+
+#define BOOT_BAUDIV (SERIAL_U2X | (u16)(((u32)(F_CPU) + 4 * (u32)BOOT_BAUD) / (8 * (u32)BOOT_BAUD) - 1))
+#define APP_PAGES (BOOT_ADDR / SPM_PAGESIZE)
+
+u08 page[SPM_PAGESIZE];
+u08 gap;      /* a frame byte did not come in time, the frame is dropped */
+u08 image_ok; /* 'C' passed, nothing written since */
+
+/* next byte of a frame; 0 once the frame has timed out */
+static u08 getb()
+{
+	u16 n;
+	if (gap)
+		return 0;
+	for (n = 0; !serial_has_rx_data(0); n++) {
+		if (n >= BOOT_GAP_MS * 100) {
+			gap = 1;
+			return 0;
+		}
+		_delay_us(10);
+	}
+	return serial_getch(0);
+}
+
+static u16 getw()
+{
+	u08 lo = getb();
+	return lo | (getb() << 8);
+}
+
+static void putw(u16 w)
+{
+	serial_putch(0, (u08)w);
+	serial_putch(0, (u08)(w >> 8));
+}
+
+static void set_vectors(u08 ivsel)
+{
+	u08 mcucr = MCUCR & ~(_BV(IVSEL) | _BV(IVCE));
+	MCUCR = mcucr | _BV(IVCE);
+	MCUCR = mcucr | ivsel;
+}
+
+static void flash_ready()
+{
+	boot_spm_busy_wait();
+	cli();
+	boot_rww_enable();
+	sei();
+}
+
+static void run_app()
+{
+	flash_ready();
+	while (serial_has_tx_data(0));
+	_delay_us(100); /* last byte out of the shifter */
+	cli();
+	UCSR0B = 0;
+	set_vectors(0);
+	((void (*)(void))0)();
+}
+
+static void program_page()
+{
+	u16 n = getw();
+	u16 crc = 0;
+	u16 i;
+	for (i = 0; i < SPM_PAGESIZE; i++) {
+		page[i] = getb();
+		crc = _crc_xmodem_update(crc, page[i]);
+	}
+	u16 want = getw();
+	if (gap)
+		return;
+	if (want != crc || n >= APP_PAGES) {
+		serial_putch(0, '!');
+		return;
+	}
+	u16 addr = n * SPM_PAGESIZE;
+	flash_ready(); /* previous page written, application section readable */
+	if (!memcmp_P(page, (PGM_P)addr, SPM_PAGESIZE)) {
+		serial_putch(0, '=');
+		return;
+	}
+	image_ok = 0;
+	serial_putch(0, '.'); /* go ahead with the next one */
+	cli(); /* SPM must follow its SPMCSR write within 4 cycles */
+	for (i = 0; i < SPM_PAGESIZE; i += 2)
+		boot_page_fill(addr + i, page[i] | (page[i + 1] << 8));
+	boot_page_erase(addr);
+	sei();
+	boot_spm_busy_wait();
+	cli();
+	boot_page_write(addr);
+	sei();
+}
+
+static void check_image()
+{
+	u16 n = getw();
+	u16 want = getw();
+	u16 crc = 0;
+	u16 addr;
+	if (gap)
+		return;
+	image_ok = 0;
+	flash_ready();
+	if (n > APP_PAGES) {
+		serial_putch(0, 'E');
+		return;
+	}
+	for (addr = 0; addr < n * SPM_PAGESIZE; addr++)
+		crc = _crc_xmodem_update(crc, pgm_read_byte(addr));
+	image_ok = crc == want;
+	serial_putch(0, image_ok ? 'K' : 'E');
+}
+
+int main(void)
+{
+	u16 n;
+
+	set_vectors(_BV(IVSEL));
+	serial_init_div(0, BOOT_BAUDIV, SERIAL_BITS_8, SERIAL_PARITY_NONE, SERIAL_STOP_BITS_1);
+	sei();
+
+	for (n = 0; n < BOOT_WAIT_MS * 10 && !serial_has_rx_data(0); n++)
+		_delay_us(100);
+	if (!serial_has_rx_data(0) && pgm_read_word(0) != 0xffff)
+		run_app();
+
+	while (1) {
+		gap = 0;
+		switch (serial_getch(0)) {
+		case '?':
+			serial_putch(0, 'T');
+			putw(SPM_PAGESIZE);
+			putw(APP_PAGES);
+			break;
+		case 'P':
+			program_page();
+			break;
+		case 'C':
+			check_image();
+			break;
+		case 'G':
+			if (!image_ok) {
+				serial_putch(0, 'E');
+				break;
+			}
+			serial_putch(0, 'G');
+			run_app();
+			break;
+		}
+	}
+}
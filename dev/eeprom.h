@@ -0,0 +1,193 @@
+/*
+ * eeprom.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Interrupt-driven EEPROM writes and a wear-levelled, CRC-checked
+ * record store with a RAM cache
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _EEPROM_H_
+#define _EEPROM_H_
+
+#include "avrutil.h"
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include <string.h>
+
+/*
+Writes:
+ee_write(addr, buf, len) queues a block and returns at once; the
+EE_READY interrupt then programs one byte per ~3.3ms. Bytes that already
+hold the right value are skipped without waiting. buf must stay intact
+until ee_busy() returns false. Do not read the EEPROM directly while
+ee_busy().
+
+Record store:
+#define EEREC_ADDR  0      // first byte used
+#define EEREC_SIZE  6      // payload bytes
+#define EEREC_SLOTS 16     // copies rotated through, at most 127
+#define EEREC_MAGIC 0x5a01 // change when the payload layout changes
+#include "dev/eeprom.h"
+
+The payload is cached in eerec_data[]; read it from there. Each save goes
+to the next slot as [seq][payload][crc16], so wear is spread over all
+slots and a save interrupted by a reset leaves the previous copy valid.
+
+if (!eerec_load())                    // at startup, blocking
+    set_defaults(eerec_data);
+...
+memcpy(eerec_data, &duty, sizeof(duty));
+eerec_save();                         // returns false if still busy
+*/
+
+#ifndef EE_QUEUE_LEN
+#define EE_QUEUE_LEN 4 /* slots, power of 2, up to 256; holds one less */
+#endif
+
+#ifndef EE_READY_vect
+#define EE_READY_vect EE_RDY_vect
+#endif
+#ifndef EEMPE
+#define EEMPE EEMWE
+#define EEPE  EEWE
+#endif
+
+struct ee_req {
+	u16 addr;
+	const u08 *src;
+	u08 len;
+};
+
+/* requests waiting; EE_READY pops one at a time into ee_cur */
+#define RING_NAME ee_queue
+#define RING_TYPE struct ee_req
+#define RING_SIZE EE_QUEUE_LEN
+#include "sys/ring.h"
+
+/* EERIE stays on until the last request has been started, EEPE until its last byte is written */
+static inline bool ee_busy() { return ee_queue_has_data() || (EECR & (_BV(EERIE) | _BV(EEPE))); }
+
+/* main loop only */
+static inline bool ee_write(u16 addr, const void *src, u08 len)
+{
+	struct ee_req r = { addr, (const u08 *)src, len };
+	if (!ee_queue_push(r))
+		return false;
+	EECR |= _BV(EERIE); /* fires as soon as no write is in progress */
+	return true;
+}
+
+#ifdef EEREC_SIZE
+
+#ifndef EEREC_ADDR
+#define EEREC_ADDR 0
+#endif
+#ifndef EEREC_SLOTS
+#define EEREC_SLOTS 8
+#endif
+#ifndef EEREC_MAGIC
+#define EEREC_MAGIC 0x5a00
+#endif
+
+#define EEREC_SLOT_SIZE (EEREC_SIZE + 3)
+
+extern u08 eerec_data[EEREC_SIZE];
+
+bool eerec_load();
+bool eerec_save();
+
+#endif /* EEREC_SIZE */
+
+#ifdef MAIN /* define ISRs in just one .c file */
+
+static struct ee_req ee_cur; /* the request being written, ISR only */
+
+ISR(EE_READY_vect) /* no write in progress */
+{
+	do {
+		while (ee_cur.len) {
+			u08 c = *ee_cur.src++;
+			EEAR = ee_cur.addr++;
+			ee_cur.len--;
+			EECR |= _BV(EERE);
+			if (EEDR != c) {
+				EEDR = c;
+				EECR |= _BV(EEMPE);
+				EECR |= _BV(EEPE); /* interrupt again when done */
+				return;
+			}
+		}
+	} while (ee_queue_pop(&ee_cur));
+	EECR &= ~_BV(EERIE);
+}
+
+#ifdef EEREC_SIZE
+
+u08 eerec_data[EEREC_SIZE];
+static u08 eerec_stage[EEREC_SLOT_SIZE]; /* copy being written, eerec_data stays free to change */
+static u08 eerec_seq;
+static u08 eerec_slot = EEREC_SLOTS - 1; /* so that the first save goes to slot 0 */
+
+static u16 eerec_crc(const u08 *p)
+{
+	u16 crc = EEREC_MAGIC;
+	u08 i;
+	for (i = 0; i < EEREC_SIZE + 1; i++)
+		crc = _crc16_update(crc, p[i]);
+	return crc;
+}
+
+bool eerec_load()
+{
+	u08 slot;
+	bool found = false;
+	for (slot = 0; slot < EEREC_SLOTS; slot++) {
+		eeprom_read_block(eerec_stage, (const void *)(EEREC_ADDR + slot * EEREC_SLOT_SIZE), EEREC_SLOT_SIZE);
+		u16 crc = eerec_stage[EEREC_SIZE + 1] | (eerec_stage[EEREC_SIZE + 2] << 8);
+		if (crc != eerec_crc(eerec_stage))
+			continue;
+		if (found && (i08)(eerec_stage[0] - eerec_seq) <= 0)
+			continue;
+		found = true;
+		eerec_seq = eerec_stage[0];
+		eerec_slot = slot;
+		memcpy(eerec_data, eerec_stage + 1, EEREC_SIZE);
+	}
+	return found;
+}
+
+bool eerec_save()
+{
+	if (ee_busy())
+		return false;
+	u08 slot = eerec_slot + 1;
+	if (slot == EEREC_SLOTS)
+		slot = 0;
+	eerec_stage[0] = ++eerec_seq;
+	memcpy(eerec_stage + 1, eerec_data, EEREC_SIZE);
+	u16 crc = eerec_crc(eerec_stage);
+	eerec_stage[EEREC_SIZE + 1] = (u08)crc;
+	eerec_stage[EEREC_SIZE + 2] = (u08)(crc >> 8);
+	eerec_slot = slot;
+	return ee_write(EEREC_ADDR + slot * EEREC_SLOT_SIZE, eerec_stage, EEREC_SLOT_SIZE);
+}
+
+#endif /* EEREC_SIZE */
+
+#endif /* MAIN */
+
+#endif
@@ -0,0 +1,334 @@
+/*
+ * modbus.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Modbus RTU slave: frames are collected in the serial receive
+ * interrupt, delimited by Timer1 and answered from a callback table
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _MODBUS_H_
+#define _MODBUS_H_
+
+/*
+Usage (include this instead of, not after, dev/serial.h):
+#define MODBUS_UART 1
+#define MODBUS_BAUD 19200
+#define BUS_TXEN1_USE 1   // RS-485 driver enable, see serial-impl.h
+...
+#include "dev/modbus.h"
+
+u16 get_temp(u16 addr) { return temp[addr - 100]; }
+u08 set_sp(u16 addr, u16 v) { if (v > 1000) return MODBUS_EX_VALUE; sp = v; return 0; }
+const struct modbus_regs modbus_table[] = {
+	{ MODBUS_INPUT_REGS, 100, 8, get_temp, 0 },
+	{ MODBUS_HOLDING,    200, 1, get_sp, set_sp },
+	{ MODBUS_COILS,        0, 4, get_relay, set_relay }, // coils: 0/1
+	{ 0 }
+};
+...
+hrt_init();
+modbus_addr = 17;
+modbus_init();
+sei();
+
+Each received byte is timestamped with Timer1 in the receive interrupt
+and folded into the frame CRC. A gap of more than 1.5 characters inside
+a frame spoils it, 3.5 characters of silence (the Timer1 compare A unit,
+which this file owns) end it. The frame is then checked and answered
+right there, in the compare interrupt, so the reply starts as soon as
+the bus has been quiet long enough; the callbacks run in that interrupt
+too and must be short. Function codes 1-6, 15 and 16 are handled; an
+access must fall within one table entry. Broadcasts (address 0) run
+only the writes, 5, 6, 15 and 16, and are never answered.
+
+The engine is the only user of the UART: do not serial_putch or
+serial_getch on it from elsewhere.
+*/
+
+#ifdef _SERIAL_H_
+#error include dev/modbus.h before dev/serial.h
+#endif
+
+#include "avrutil.h"
+#include <util/crc16.h>
+
+#ifndef MODBUS_UART
+#define MODBUS_UART 0
+#endif
+#ifndef MODBUS_BAUD
+#define MODBUS_BAUD 19200
+#endif
+#ifndef MODBUS_PARITY
+#define MODBUS_PARITY SERIAL_PARITY_EVEN
+#endif
+
+/* table entry types, the function codes that read them */
+#define MODBUS_COILS      1
+#define MODBUS_INPUTS     2
+#define MODBUS_HOLDING    3
+#define MODBUS_INPUT_REGS 4
+
+/* exception codes, returned by write callbacks */
+#define MODBUS_EX_FUNCTION 1
+#define MODBUS_EX_ADDRESS  2
+#define MODBUS_EX_VALUE    3
+#define MODBUS_EX_FAILURE  4
+
+struct modbus_regs {
+	u08 type;
+	u16 start;
+	u16 count;
+	u16 (*read)(u16 addr);
+	u08 (*write)(u16 addr, u16 value); /* 0: read only */
+};
+
+extern const struct modbus_regs modbus_table[]; /* ends with type 0 */
+extern u08 modbus_addr;
+extern u16 modbus_frames; /* answered or broadcast */
+extern u16 modbus_errors; /* dropped: CRC, gap, framing */
+
+void modbus_rx(u08 c, u08 err);
+
+#if MODBUS_UART == 0
+#define SERIAL_RX_HOOK0_USE 1
+#define SERIAL_RX_HOOK0(c, err) modbus_rx(c, err)
+#elif MODBUS_UART == 1
+#define SERIAL_RX_HOOK1_USE 1
+#define SERIAL_RX_HOOK1(c, err) modbus_rx(c, err)
+#elif MODBUS_UART == 2
+#define SERIAL_RX_HOOK2_USE 1
+#define SERIAL_RX_HOOK2(c, err) modbus_rx(c, err)
+#else
+#define SERIAL_RX_HOOK3_USE 1
+#define SERIAL_RX_HOOK3(c, err) modbus_rx(c, err)
+#endif
+
+#include "dev/serial.h"
+#include "sys/hrt.h"
+
+/* start, 8 data, parity if any, 1 stop (modbus_init) */
+#if MODBUS_PARITY == SERIAL_PARITY_NONE
+#define MODBUS_BITS 10
+#else
+#define MODBUS_BITS 11
+#endif
+
+/* Timer1 counts; above 19200 baud the standard fixes 750us and 1750us */
+#define MODBUS_CHAR ((u16)((u32)MODBUS_BITS * (F_CPU) / HRT_PRESCALE / MODBUS_BAUD))
+#if MODBUS_BAUD > 19200
+#define MODBUS_T15 HRT_US_TO_COUNTS(750)
+#define MODBUS_T35 HRT_US_TO_COUNTS(1750)
+#else
+#define MODBUS_T15 ((u16)(MODBUS_CHAR * 3 / 2))
+#define MODBUS_T35 ((u16)(MODBUS_CHAR * 7 / 2))
+#endif
+#if MODBUS_BITS * 7UL / 2 * (F_CPU) / HRT_PRESCALE / MODBUS_BAUD > 0x7fff
+#error MODBUS_BAUD too low for the Timer1 prescaler, raise HRT_PRESCALE
+#endif
+
+static inline void modbus_init()
+{
+	serial_init(MODBUS_UART, MODBUS_BAUD, SERIAL_BITS_8, MODBUS_PARITY, SERIAL_STOP_BITS_1);
+}
+
+#ifdef MAIN /* define ISRs in just one .c file */
+
+u08 modbus_addr;
+u16 modbus_frames;
+u16 modbus_errors;
+u08 modbus_buf[256];
+u16 modbus_len;
+u16 modbus_crc = 0xffff;
+u16 modbus_last;
+u08 modbus_bad;
+
+void modbus_rx(u08 c, u08 err) /* called from interrupt */
+{
+	u16 now = TCNT1;
+	u16 len = modbus_len;
+	if (len && (u16)(now - modbus_last) > MODBUS_CHAR + MODBUS_T15)
+		modbus_bad = 1; /* a char already took MODBUS_CHAR to arrive, the rest is gap */
+	modbus_last = now;
+	OCR1A = now + MODBUS_T35;
+#ifdef TIFR1
+	TIFR1 = _BV(OCF1A);
+	TIMSK1 |= _BV(OCIE1A);
+#else
+	TIFR = _BV(OCF1A);
+	TIMSK |= _BV(OCIE1A);
+#endif
+	if (err || len == sizeof(modbus_buf)) {
+		modbus_bad = 1;
+		return;
+	}
+	modbus_buf[len] = c;
+	modbus_len = len + 1;
+	modbus_crc = _crc16_update(modbus_crc, c);
+}
+
+static const struct modbus_regs *modbus_find(u08 type, u16 addr, u16 n, u08 writing)
+{
+	const struct modbus_regs *r;
+	for (r = modbus_table; r->type; r++) /* no sums: addr + n may wrap at 16 bits */
+		if (r->type == type && addr >= r->start && n <= r->count && addr - r->start <= r->count - n && (!writing || r->write))
+			return r;
+	return 0;
+}
+
+/* answer the frame in modbus_buf, in place; returns the reply length, without CRC */
+static u08 modbus_frame()
+{
+	u08 *b = modbus_buf;
+	u08 fn = b[1];
+	u16 addr = ((u16)b[2] << 8) | b[3];
+	u16 n = ((u16)b[4] << 8) | b[5];
+	u16 len = modbus_len - 2;
+	const struct modbus_regs *r;
+	u08 ex = 0, reply = 6, bytes;
+	u16 i;
+
+	switch (fn) {
+	case 1: /* read coils */
+	case 2: /* read discrete inputs */
+		if (len != 6)
+			return 0;
+		if (n < 1 || n > 2000)
+			ex = MODBUS_EX_VALUE;
+		else if (!(r = modbus_find(fn, addr, n, 0)))
+			ex = MODBUS_EX_ADDRESS;
+		else {
+			bytes = (n + 7) / 8;
+			b[2] = bytes;
+			for (i = 0; i < bytes; i++)
+				b[3 + i] = 0;
+			for (i = 0; i < n; i++)
+				if (r->read(addr + i))
+					b[3 + i / 8] |= _BV(i & 7);
+			reply = 3 + bytes;
+		}
+		break;
+	case 3: /* read holding registers */
+	case 4: /* read input registers */
+		if (len != 6)
+			return 0;
+		if (n < 1 || n > 125)
+			ex = MODBUS_EX_VALUE;
+		else if (!(r = modbus_find(fn, addr, n, 0)))
+			ex = MODBUS_EX_ADDRESS;
+		else {
+			b[2] = n * 2;
+			for (i = 0; i < n; i++) {
+				u16 v = r->read(addr + i);
+				b[3 + 2 * i] = v >> 8;
+				b[4 + 2 * i] = v;
+			}
+			reply = 3 + n * 2;
+		}
+		break;
+	case 5: /* write single coil, n is the value */
+		if (len != 6)
+			return 0;
+		if (n != 0xff00 && n != 0)
+			ex = MODBUS_EX_VALUE;
+		else if (!(r = modbus_find(MODBUS_COILS, addr, 1, 1)))
+			ex = MODBUS_EX_ADDRESS;
+		else
+			ex = r->write(addr, n ? 1 : 0);
+		break;
+	case 6: /* write single register, n is the value */
+		if (len != 6)
+			return 0;
+		if (!(r = modbus_find(MODBUS_HOLDING, addr, 1, 1)))
+			ex = MODBUS_EX_ADDRESS;
+		else
+			ex = r->write(addr, n);
+		break;
+	case 15: /* write multiple coils */
+		if (len < 7 || len != 7 + b[6])
+			return 0;
+		if (n < 1 || n > 1968 || b[6] != (n + 7) / 8)
+			ex = MODBUS_EX_VALUE;
+		else if (!(r = modbus_find(MODBUS_COILS, addr, n, 1)))
+			ex = MODBUS_EX_ADDRESS;
+		else
+			for (i = 0; i < n && !ex; i++)
+				ex = r->write(addr + i, (b[7 + i / 8] >> (i & 7)) & 1);
+		break;
+	case 16: /* write multiple registers */
+		if (len < 7 || len != 7 + b[6])
+			return 0;
+		if (n < 1 || n > 123 || b[6] != n * 2)
+			ex = MODBUS_EX_VALUE;
+		else if (!(r = modbus_find(MODBUS_HOLDING, addr, n, 1)))
+			ex = MODBUS_EX_ADDRESS;
+		else
+			for (i = 0; i < n && !ex; i++)
+				ex = r->write(addr + i, ((u16)b[7 + 2 * i] << 8) | b[8 + 2 * i]);
+		break;
+	default:
+		ex = MODBUS_EX_FUNCTION;
+		break;
+	}
+	if (ex) {
+		b[1] = fn | 0x80;
+		b[2] = ex;
+		reply = 3;
+	}
+	return reply; /* writes echo address and count/value, already in place */
+}
+
+static inline u08 modbus_writes(u08 fn)
+{
+	return fn == 5 || fn == 6 || fn == 15 || fn == 16;
+}
+
+ISR(TIMER1_COMPA_vect) /* 3.5 characters of silence: end of frame */
+{
+#ifdef TIMSK1
+	TIMSK1 &= ~_BV(OCIE1A);
+#else
+	TIMSK &= ~_BV(OCIE1A);
+#endif
+	if (!modbus_len)
+		return;
+	if (modbus_bad || modbus_len < 4 || modbus_crc) /* CRC over data and CRC is 0 */
+		modbus_errors++;
+	else if (modbus_buf[0] == modbus_addr || (modbus_buf[0] == 0 && modbus_writes(modbus_buf[1]))) {
+		u08 n = modbus_frame();
+		if (!n) /* malformed request */
+			modbus_errors++;
+		else
+			modbus_frames++;
+		if (n && modbus_buf[0]) { /* no reply to broadcasts */
+			u08 i;
+			u16 crc = 0xffff;
+			for (i = 0; i < n; i++) {
+				serial_putch(MODBUS_UART, modbus_buf[i]); /* the first one goes out at once */
+				crc = _crc16_update(crc, modbus_buf[i]);
+			}
+			serial_putch(MODBUS_UART, (u08)crc);
+			serial_putch(MODBUS_UART, (u08)(crc >> 8));
+		}
+	}
+	modbus_len = 0;
+	modbus_crc = 0xffff;
+	modbus_bad = 0;
+}
+
+#endif /* MAIN */
+
+#endif
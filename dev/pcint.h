@@ -0,0 +1,162 @@
+/*
+ * pcint.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Pin change interrupts dispatched to handlers by pin function
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _PCINT_H_
+#define _PCINT_H_
+
+#include "avrutil.h"
+
+/*
+Usage:
+void key_down(int active);    // handlers get the new logic level
+void door_moved(int active);
+#define PCINT_HANDLERS(on) \
+	on(KEY,  PCINT_RISING, key_down)              \
+	on(DOOR, PCINT_BOTH | PCINT_DPC, door_moved)
+#include "dev/pcint.h"
+...
+pcint_init();  // masks, enables, first snapshot
+
+Rising and falling are in logic terms, polarity applied: PCINT_RISING
+runs the handler when the function becomes active. Inline handlers run
+in the interrupt; with PCINT_DPC the handler is posted with dpc_post
+instead (needs PCINT_USE_DPC and sys/dpc.h).
+
+Everything is resolved at compile time: each port's vector reads PINx
+once, XORs it with the previous read and tests the changed bits of the
+functions on that port with constant masks; the handlers of other ports
+compile away. Vectors are generated for the groups in PCINT_GROUPS
+(bit n: PCINTn_vect), by default the groups that have a handler; set it
+to leave out any the application defines itself. Changes shorter than the interrupt latency, or two
+changes before the interrupt runs, are not seen.
+*/
+
+#define PCINT_RISING  1
+#define PCINT_FALLING 2
+#define PCINT_BOTH    3
+#define PCINT_DPC     4
+
+#ifdef PCINT_USE_DPC
+#include "sys/dpc.h"
+#endif
+
+#if defined(PCMSK3) /* ATmega164/324/644/1284: PCINT0..31 on ports A..D */
+#define _PCINT_GROUP_A 0
+#define _PCINT_GROUP_B 1
+#define _PCINT_GROUP_C 2
+#define _PCINT_GROUP_D 3
+#define _PCINT_PIN0 PINA
+#define _PCINT_PIN1 PINB
+#define _PCINT_PIN2 PINC
+#define _PCINT_PIN3 PIND
+#elif defined(PCMSK2) /* ATmega48/88/168/328: ports B, C, D */
+#define _PCINT_GROUP_B 0
+#define _PCINT_GROUP_C 1
+#define _PCINT_GROUP_D 2
+#define _PCINT_PIN0 PINB
+#define _PCINT_PIN1 PINC
+#define _PCINT_PIN2 PIND
+#else
+#error pcint.h does not know the pin change groups of this device
+#endif
+
+#define _PCINT_GROUP(func) CATX(_PCINT_GROUP_, CAT(func, _PRT))
+
+/* the handler list folded in #if: groups used, edge flags used */
+#define _PCINT_GROUP_BIT(func, edge, handler) | _BV(_PCINT_GROUP(func))
+#define _PCINT_EDGE_BITS(func, edge, handler) | (edge)
+
+#ifndef PCINT_GROUPS
+#define PCINT_GROUPS (0 PCINT_HANDLERS(_PCINT_GROUP_BIT))
+#endif
+
+#if !defined(PCINT_USE_DPC) && ((0 PCINT_HANDLERS(_PCINT_EDGE_BITS)) & PCINT_DPC)
+#error PCINT_DPC handlers need PCINT_USE_DPC
+#endif
+
+extern u08 pcint_snap[4];
+
+#define _PCINT_INIT(func, edge, handler) \
+	CATX(PCMSK, _PCINT_GROUP(func)) |= _BV(CAT(func, _PIN)); \
+	PCICR |= _BV(CATX(PCIE, _PCINT_GROUP(func))); \
+	pcint_snap[_PCINT_GROUP(func)] = CATX(_PCINT_PIN, _PCINT_GROUP(func));
+
+static inline void pcint_init()
+{
+	u08 sreg = SREG;
+	cli();
+	PCINT_HANDLERS(_PCINT_INIT)
+	PCIFR = PCIFR; /* drop changes seen before the snapshot */
+	SREG = sreg;
+}
+
+#ifdef MAIN /* define ISRs in just one .c file */
+
+u08 pcint_snap[4];
+
+#ifdef PCINT_USE_DPC
+#define _PCINT_CALL(edge, handler, active) \
+	if ((edge) & PCINT_DPC) \
+		dpc_post(handler, active); \
+	else \
+		handler(active)
+#else
+#define _PCINT_CALL(edge, handler, active) handler(active)
+#endif
+
+/* in the vector of group g, with now and chg of that port */
+#define _PCINT_ON(g, func, edge, handler) \
+	if (_PCINT_GROUP(func) == (g) && (chg & _BV(CAT(func, _PIN)))) { \
+		u08 active = ((now & _BV(CAT(func, _PIN))) ? 1 : 0) == CAT(func, _POL); \
+		if ((edge) & (active ? PCINT_RISING : PCINT_FALLING)) { \
+			_PCINT_CALL(edge, handler, active); \
+		} \
+	}
+#define _PCINT_ON0(func, edge, handler) _PCINT_ON(0, func, edge, handler)
+#define _PCINT_ON1(func, edge, handler) _PCINT_ON(1, func, edge, handler)
+#define _PCINT_ON2(func, edge, handler) _PCINT_ON(2, func, edge, handler)
+#define _PCINT_ON3(func, edge, handler) _PCINT_ON(3, func, edge, handler)
+
+#define _PCINT_VECT(g) \
+ISR(CATX(PCINT, CATX(g, _vect))) \
+{ \
+	u08 now = CATX(_PCINT_PIN, g); \
+	u08 chg = now ^ pcint_snap[g]; \
+	pcint_snap[g] = now; \
+	PCINT_HANDLERS(CATX(_PCINT_ON, g)) \
+}
+
+#if defined(_PCINT_PIN0) && (PCINT_GROUPS & 1)
+_PCINT_VECT(0)
+#endif
+#if defined(_PCINT_PIN1) && (PCINT_GROUPS & 2)
+_PCINT_VECT(1)
+#endif
+#if defined(_PCINT_PIN2) && (PCINT_GROUPS & 4)
+_PCINT_VECT(2)
+#endif
+#if defined(_PCINT_PIN3) && (PCINT_GROUPS & 8)
+_PCINT_VECT(3)
+#endif
+
+#endif /* MAIN */
+
+#endif
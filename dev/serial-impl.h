@@ -26,12 +26,8 @@
 
 #ifdef UART_NUM
 /* ATmega128 e.g. has definitions for both unnumbered and numbered register bits */
-#undef rxbuf
-#undef txbuf
-#undef txstart
-#undef txstop
-#undef rxstart
-#undef rxstop
+#undef rxq
+#undef txq
 #undef tx_done
 #undef rx_ovf
 #undef rx_err
@@ -50,6 +46,7 @@
 #undef DOR
 #undef UPE
 #undef MPCM
+#undef U2X
 
 #undef RXCIE
 #undef TXCIE
@@ -66,12 +63,8 @@
 #undef UCSZ0
 
 /* define generic vars, regs, bits */
-#define rxbuf   CATX(rxbuf,   UART_NUM)
-#define txbuf   CATX(txbuf,   UART_NUM)
-#define txstart CATX(txstart, UART_NUM)
-#define txstop  CATX(txstop,  UART_NUM)
-#define rxstart CATX(rxstart, UART_NUM)
-#define rxstop  CATX(rxstop,  UART_NUM)
+#define rxq     CATX(rxq,     UART_NUM) /* rings, see sys/ring.h */
+#define txq     CATX(txq,     UART_NUM)
 #define tx_done CATX(tx_done, UART_NUM)
 #define rx_ovf  CATX(rx_ovf,  UART_NUM)
 #define rx_err  CATX(rx_err,  UART_NUM)
@@ -90,6 +83,7 @@
 #define DOR   CATX(DOR,  UART_NUM)
 #define UPE   CATX(UPE,  UART_NUM)
 #define MPCM  CATX(MPCM, UART_NUM)
+#define U2X   CATX(U2X,  UART_NUM)
 
 #define RXCIE CATX(RXCIE, UART_NUM)
 #define TXCIE CATX(TXCIE, UART_NUM)
@@ -112,60 +106,105 @@
 #define serial_can_tx      CATX(serial_can_tx,        UART_NUM)
 #define serial_has_rx_data CATX(serial_has_rx_data,   UART_NUM)
 #define serial_has_tx_data CATX(serial_has_tx_data,   UART_NUM)
+#define serial_tx_space    CATX(serial_tx_space,      UART_NUM)
 #define _serial_putch      CATX(_serial_putch,        UART_NUM)
 #define _serial_getch      CATX(_serial_getch,        UART_NUM)
 #define _serial_init_div   CATX(_serial_init_div,     UART_NUM)
 #define _serial_init       CATX(_serial_init,         UART_NUM)
 #define USART_RX_func      CATX(USART_RX_func,        UART_NUM)
+#define USART_UDRE_func    CATX(USART_UDRE_func,      UART_NUM)
+#define USART_TX_func      CATX(USART_TX_func,        UART_NUM)
 #define USART_RX_vect      CATX(USART, CATX(UART_NUM, _RX_vect))
 #define USART_TX_vect      CATX(USART, CATX(UART_NUM, _TX_vect))
 #define USART_UDRE_vect    CATX(USART, CATX(UART_NUM, _UDRE_vect))
+#define _serial_bridge_rx  CATX(_serial_bridge_rx,    UART_NUM)
+#define SERIAL_N           UART_NUM
 
+#else
+#define SERIAL_N           0
 #endif
 
-extern u08 rxbuf[256]; /* byte wraparound makes circular buffer */
-extern u08 txbuf[256];
-extern volatile u08 txstart;
-extern volatile u08 txstop;
-extern volatile u08 rxstart;
-extern volatile u08 rxstop;
+/*
+Ring protocol: rxq and txq are sys/ring.h rings of 256 bytes, one
+producer and one consumer each:
+rx: USART_RX_func pushes, _serial_getch pops.
+tx: _serial_putch pushes, then sets UDRIE; USART_UDRE_func pops into
+    UDR, and clears UDRIE only when it sees the ring empty, which no
+    push can change while it runs.
+_serial_putch may bypass the ring only when it is empty and UDR is free:
+the consumer is then idle and cannot be holding an older byte. The
+*_func bodies are kept apart from the ISR wrappers so they can be driven
+step by step off-target; test/serial_tx.cpp and test/serial_rx.cpp run
+the rings against every interleaving (make check).
+*/
+#define RING_NAME rxq
+#define RING_TYPE u08
+#define RING_SIZE 256
+#include "sys/ring.h"
+
+#define RING_NAME txq
+#define RING_TYPE u08
+#define RING_SIZE 256
+#include "sys/ring.h"
+
+#define _rx_push     CATX(rxq, _push)
+#define _rx_pop      CATX(rxq, _pop)
+#define _rx_can_push CATX(rxq, _can_push)
+#define _rx_has_data CATX(rxq, _has_data)
+#define _tx_push     CATX(txq, _push)
+#define _tx_pop      CATX(txq, _pop)
+#define _tx_can_push CATX(txq, _can_push)
+#define _tx_has_data CATX(txq, _has_data)
+#define _tx_space    CATX(txq, _space)
+
 extern u08 rx_ovf;
 extern u08 rx_err;
 
-static inline int serial_can_rx() { return rxstop + 1 != rxstart; }
-static inline int serial_can_tx() { return txstop + 1 != txstart; }
-static inline int serial_has_rx_data() { return rxstart != rxstop; }
-static inline int serial_has_tx_data() { return txstart != txstop; }
+static inline int serial_can_rx() { return _rx_can_push(); }
+static inline int serial_can_tx() { return _tx_can_push(); }
+static inline int serial_has_rx_data() { return _rx_has_data(); }
+static inline int serial_has_tx_data() { return _tx_has_data(); }
+static inline u08 serial_tx_space() { return _tx_space(); } /* bytes putch takes without waiting */
 
 /* no simultaneous calls allowed */
 static inline void _serial_putch(u08 c)
 {
-	u08 txstop_l;
-	txstop_l = txstop;
-	while ((u08)(txstop_l + 1) == txstart);
-	txbuf[txstop_l] = c;
-	txstop = txstop_l + 1;
+	while (!_tx_can_push());
 #if (CATX(BUS_TXEN, _USE))
+	/* bus on, byte handed over and stale TXC dropped as one step: a TXC
+	   interrupt in between would release the bus under the new byte */
 	port_optimize_declare();
+	u08 sreg = SREG;
+	cli();
 	set_pin(BUS_TXEN);
 	// TODO: delay?
 #endif
-	UCSRB |= _BV(UDRIE); /* calls ISR */
+	if (!_tx_has_data() && (UCSRA & _BV(UDRE))) {
+		/* line idle and nothing queued (the ISR only pops when something is): skip ring and interrupt */
+		UDR = c;
+	}
+	else {
+		_tx_push(c);
+		UCSRB |= _BV(UDRIE); /* calls ISR */
+	}
+#if (CATX(BUS_TXEN, _USE))
+	UCSRA = (UCSRA & (_BV(U2X) | _BV(MPCM))) | _BV(TXC); /* only an earlier byte can have set it, not this one yet */
+	SREG = sreg;
+#endif
 }
 
 /* no simultaneous calls allowed */
 static inline u08 _serial_getch()
 {
-	u08 rxstart_l = rxstart;
-	while (rxstart_l == rxstop);
-	u08 c = rxbuf[rxstart_l];
-	rxstart = rxstart_l + 1;
+	u08 c;
+	while (!_rx_pop(&c));
 	return c;
 }
 
 static inline void _serial_init_div(u16 baudiv, u16 data_bits, u16 parity_bits, u16 stop_bits)
 {
-	UBRRH = (u08)(baudiv >> 8);
+	UCSRA = (baudiv & SERIAL_U2X) ? _BV(U2X) : 0;
+	UBRRH = (u08)(baudiv >> 8) & 0x0f;
 	UBRRL = (u08)baudiv;
 
 	/* HACK: should fall in place */
@@ -186,12 +225,6 @@ static inline void _serial_init(u32 baud, u16 data_bits, u16 parity_bits, u16 st
 
 #ifdef MAIN /* define ISRs in just one .c file */
 
-u08 rxbuf[256]; /* byte wraparound makes circular buffer */
-u08 txbuf[256];
-volatile u08 txstart;
-volatile u08 txstop;
-volatile u08 rxstart;
-volatile u08 rxstop;
 u08 tx_done;
 u08 rx_err;
 u08 rx_ovf;
@@ -201,19 +234,19 @@ static inline
 #endif
 void USART_RX_func(int param) /* called from interrupt */
 {
-	u08 rxstop_l = rxstop;
 #ifdef SERIAL_USE_DPC
 	while (UCSRA & _BV(RXC)) /* have data */
 #endif
 	{
-		if ((u08)(rxstop_l + 1) != rxstart) { /* have buffer */
+		if (_rx_can_push()) { /* have buffer */
 			if (UCSRA & (_BV(FE) | _BV(DOR) | _BV(UPE))) {
 				rx_err = 1;
 				if (UCSRA & _BV(DOR))
 					rx_ovf = 1;
 			}
-			rxbuf[rxstop_l] = UDR;
-			rxstop = rxstop_l + 1;
+			u08 c = UDR;
+			_rx_push(c);
+			trace1(TRACE_RX + SERIAL_N, c);
 #ifdef SERIAL_USE_DPC
 			if (param)
 				UCSRB |= _BV(RXCIE);
@@ -225,6 +258,8 @@ void USART_RX_func(int param) /* called from interrupt */
 			dpc_post(&USART_RX_func, 1);
 			return;
 #else
+		if (!rx_ovf) /* runs again until there is room, trace that once */
+			trace2(TRACE_RX + SERIAL_N, 0, 1);
 		rx_err = 1;
 		rx_ovf = 1;
 #endif
@@ -232,29 +267,73 @@ void USART_RX_func(int param) /* called from interrupt */
 	}
 }
 
+#if (CATX(SERIAL_BRIDGE, CATX(SERIAL_N, _USE)))
+void _serial_bridge_rx();
+#endif
+
 ISR(USART_RX_vect) /* byte receive complete */
 {
-	USART_RX_func(0);
+	lat_enter();
+#if (CATX(SERIAL_RX_HOOK, CATX(SERIAL_N, _USE)))
+	u08 err = UCSRA & (_BV(FE) | _BV(DOR) | _BV(UPE));
+	u08 c = UDR;
+	CATX(SERIAL_RX_HOOK, SERIAL_N)(c, err);
+#else
+#if (CATX(SERIAL_BRIDGE, CATX(SERIAL_N, _USE)))
+	if (serial_bridged & _BV(SERIAL_N))
+		_serial_bridge_rx();
+	else
+#endif
+		USART_RX_func(0);
+#endif
+	lat_exit(LAT_RX(SERIAL_N));
 }
 
-ISR(USART_UDRE_vect) /* data register empty */
+static inline void USART_UDRE_func() /* called from interrupt */
 {
-	u08 txstart_l = txstart;
-	if (txstart_l != txstop) {
-		UDR = txbuf[txstart_l + 1]; /* feed one more byte, will be triggered again */
-		txstart = txstart_l + 1;
+	u08 c, n = 0;
+	while (_tx_pop(&c)) {
+		UDR = c;
+#if (CATX(BUS_TXEN, _USE))
+		/* may have come later than a frame: TXC of the byte before must not
+		   release the bus; dropped at once, before this byte can be out */
+		UCSRA = (UCSRA & (_BV(U2X) | _BV(MPCM))) | _BV(TXC);
+#endif
+		n++;
+		if (!(UCSRA & _BV(UDRE))) /* shifter busy, wait for the next interrupt */
+			break;
 	}
-	else
+#if SERIAL_N != TRACE_UART /* would trace its own output forever */
+	trace1(TRACE_UDRE + SERIAL_N, n);
+#endif
+	if (!_tx_has_data())
 		UCSRB &= ~_BV(UDRIE); /* no more bytes, don't trigger again */
 }
 
-ISR(USART_TX_vect) /* all bytes transmitted */
+static inline void USART_TX_func() /* called from interrupt */
 {
+#if SERIAL_N != TRACE_UART
+	trace0(TRACE_TXC + SERIAL_N);
+#endif
 #if (CATX(BUS_TXEN, _USE))
 	port_optimize_declare();
 	clr_pin(BUS_TXEN);
 #endif
 }
+
+ISR(USART_UDRE_vect) /* data register empty */
+{
+	lat_enter();
+	USART_UDRE_func();
+	lat_exit(LAT_UDRE(SERIAL_N));
+}
+
+ISR(USART_TX_vect) /* all bytes transmitted */
+{
+	lat_enter();
+	USART_TX_func();
+	lat_exit(LAT_TXC(SERIAL_N));
+}
 #endif /* MAIN */
 
 /* functions */
@@ -262,11 +341,25 @@ ISR(USART_TX_vect) /* all bytes transmitted */
 #undef serial_can_tx
 #undef serial_has_rx_data
 #undef serial_has_tx_data
+#undef serial_tx_space
 #undef _serial_putch
 #undef _serial_getch
 #undef _serial_init_div
 #undef _serial_init
 #undef USART_RX_func
+#undef USART_UDRE_func
+#undef USART_TX_func
 #undef USART_RX_vect
 #undef USART_TX_vect
 #undef USART_UDRE_vect
+#undef _serial_bridge_rx
+#undef SERIAL_N
+#undef _rx_push
+#undef _rx_pop
+#undef _rx_can_push
+#undef _rx_has_data
+#undef _tx_push
+#undef _tx_pop
+#undef _tx_can_push
+#undef _tx_has_data
+#undef _tx_space
@@ -23,6 +23,8 @@
 #define _SERIAL_H_
 
 #include "avrutil.h"
+#include "sys/trace.h"
+#include "sys/lat.h"
 
 #define SER_TIMEOUT 11520 //2s
 #define TURNAROUND_DELAY_US 10
@@ -40,6 +42,56 @@
 #define SERIAL_STOP_BITS_1 0
 #define SERIAL_STOP_BITS_2 1
 
+#define SERIAL_U2X 0x8000 /* or into the serial_init_div divider for double speed mode */
+
+#ifndef SERIAL_UARTS
+#define SERIAL_UARTS 0x0f /* bit n set: instantiate UART n, if present (UART 0 always is) */
+#endif
+
+/*
+Bridge mode (multiple UARTs): bytes received on UART n are forwarded to
+the transmitter of UART m straight from the receive interrupt, without
+going through the rx ring or the main loop. When the transmitter is idle the
+byte goes directly into its UDR. For each bridged direction, e.g. 0 -> 1:
+#define SERIAL_BRIDGE0_USE 1
+#define SERIAL_BRIDGE0_TO  1
+#define SERIAL_BRIDGE0_HOOK(c) sniff(&c) // optional, runs in the ISR: may
+                                         // look at or change c, 0 drops it
+...
+serial_bridge(0, 1); // forward from now on; serial_bridge(0, 0) to stop
+
+While a bridge feeds UART m, the main loop must not serial_putch(m, ...)
+as well (the TX ring would have two producers). A byte UART m has no room
+for is dropped and rx_ovf/rx_err of UART n are set.
+*/
+extern volatile u08 serial_bridged; /* bit n: UART n RX is forwarded */
+#define serial_bridge(n, on) { \
+	if (on) \
+		serial_bridged |= _BV(n); \
+	else \
+		serial_bridged &= ~_BV(n); \
+}
+
+#ifndef SERIAL_BRIDGE0_HOOK
+#define SERIAL_BRIDGE0_HOOK(c) 1
+#endif
+#ifndef SERIAL_BRIDGE1_HOOK
+#define SERIAL_BRIDGE1_HOOK(c) 1
+#endif
+#ifndef SERIAL_BRIDGE2_HOOK
+#define SERIAL_BRIDGE2_HOOK(c) 1
+#endif
+#ifndef SERIAL_BRIDGE3_HOOK
+#define SERIAL_BRIDGE3_HOOK(c) 1
+#endif
+
+/*
+Receive hook: with SERIAL_RX_HOOKn_USE set, every byte UART n receives
+is handed to SERIAL_RX_HOOKn(c, err) from the receive interrupt instead
+of going to the rx ring (err: the FE/DOR/UPE bits of UCSRA). Protocol engines
+that need to see bytes as they arrive use it, e.g. dev/modbus.h.
+*/
+
 #ifdef UCSR0A    // multiple UARTs
 #define UART_NUM 0
 #include "dev/serial-impl.h"
@@ -48,19 +100,19 @@
 #include "dev/serial-impl.h"
 #endif
 
-#ifdef UCSR1A
+#if defined(UCSR1A) && (SERIAL_UARTS & 2)
 #define UART_NUM 1
 #include "dev/serial-impl.h"
 #undef UART_NUM
 #endif
 
-#ifdef UCSR2A
+#if defined(UCSR2A) && (SERIAL_UARTS & 4)
 #define UART_NUM 2
 #include "dev/serial-impl.h"
 #undef UART_NUM
 #endif
 
-#ifdef UCSR3A
+#if defined(UCSR3A) && (SERIAL_UARTS & 8)
 #define UART_NUM 3
 #include "dev/serial-impl.h"
 #undef UART_NUM
@@ -71,11 +123,89 @@
 #define serial_init_div(n, a, b, c, d) CATX(_serial_init_div, n) (a, b, c, d)
 #define serial_getch(n) CATX(_serial_getch, n) ()
 #define serial_putch(n, x) CATX(_serial_putch, n) (x)
+#define serial_has_rx_data(n) CATX(serial_has_rx_data, n) ()
+#define serial_has_tx_data(n) CATX(serial_has_tx_data, n) ()
+#define serial_can_tx(n) CATX(serial_can_tx, n) ()
+#define serial_tx_space(n) CATX(serial_tx_space, n) ()
+
+/* the per-UART aliases from serial-impl.h are meaningless past this point */
+#undef rxq
+#undef txq
+#undef tx_done
+#undef rx_ovf
+#undef rx_err
+#undef UCSRA
+#undef UCSRB
+#undef UCSRC
+#undef UBRRL
+#undef UBRRH
+#undef UDR
+#undef RXC
+#undef TXC
+#undef UDRE
+#undef FE
+#undef DOR
+#undef UPE
+#undef MPCM
+#undef U2X
+#undef RXCIE
+#undef TXCIE
+#undef UDRIE
+#undef RXEN
+#undef TXEN
+#undef UCSZ2
+#undef RXB8
+#undef TXB8
+#undef UPM0
+#undef USBS
+#undef UCSZ0
+#undef BUS_TXEN
+
+#ifdef MAIN
+volatile u08 serial_bridged;
+
+#define _SERIAL_BRIDGE_RX(n) \
+void CATX(_serial_bridge_rx, n)() /* called from the RX interrupt */ \
+{ \
+	u08 err = CATX(UCSR, CATX(n, A)) & (_BV(CATX(FE, n)) | _BV(CATX(DOR, n)) | _BV(CATX(UPE, n))); \
+	u08 c = CATX(UDR, n); \
+	if (err) { \
+		CATX(rx_err, n) = 1; \
+		if (err & _BV(CATX(DOR, n))) \
+			CATX(rx_ovf, n) = 1; \
+	} \
+	if (!(CATX(SERIAL_BRIDGE, CATX(n, _HOOK))(c))) \
+		return; \
+	if (serial_can_tx(CATX(SERIAL_BRIDGE, CATX(n, _TO)))) \
+		serial_putch(CATX(SERIAL_BRIDGE, CATX(n, _TO)), c); \
+	else { \
+		CATX(rx_err, n) = 1; \
+		CATX(rx_ovf, n) = 1; \
+	} \
+}
+
+#if SERIAL_BRIDGE0_USE
+_SERIAL_BRIDGE_RX(0)
+#endif
+#if SERIAL_BRIDGE1_USE
+_SERIAL_BRIDGE_RX(1)
+#endif
+#if SERIAL_BRIDGE2_USE
+_SERIAL_BRIDGE_RX(2)
+#endif
+#if SERIAL_BRIDGE3_USE
+_SERIAL_BRIDGE_RX(3)
+#endif
+#endif /* MAIN */
 #else
 #define serial_init(n, a, b, c, d) _serial_init(a, b, c, d)
 #define serial_init_div(n, a, b, c, d) _serial_init_div(a, b, c, d)
 #define serial_getch(n) _serial_getch()
 #define serial_putch(n, x) _serial_putch(x)
+#define serial_has_rx_data(n) serial_has_rx_data()
+#define serial_has_tx_data(n) serial_has_tx_data()
+#define serial_can_tx(n) serial_can_tx()
+#define serial_tx_space(n) serial_tx_space()
 #endif
 
 #endif
@@ -0,0 +1,227 @@
+/*
+ * spi-impl.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Queued, interrupt-driven SPI master driver, device-independent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+
+#ifndef _SPI_H_
+#error Do not include this file directly, include spi.h
+#endif
+
+/* vars */
+#define _spi_head   CATX(_spi_head_,   SPI_DEV)
+#define _spi_tail   CATX(_spi_tail_,   SPI_DEV)
+#define _spi_pos    CATX(_spi_pos_,    SPI_DEV)
+#define _spi_sent   CATX(_spi_sent_,   SPI_DEV)
+
+/* functions */
+#define _spi_init   CATX(_spi_init_,   SPI_DEV)
+#define _spi_submit CATX(_spi_submit_, SPI_DEV)
+#define _spi_start  CATX(_spi_start_,  SPI_DEV)
+#define _spi_finish CATX(_spi_finish_, SPI_DEV)
+
+#ifdef SPI_UART
+#define _SPI_UCSRA  CATX(UCSR, CATX(SPI_UART, A))
+#define _SPI_UCSRB  CATX(UCSR, CATX(SPI_UART, B))
+#define _SPI_UCSRC  CATX(UCSR, CATX(SPI_UART, C))
+#define _SPI_UBRRL  CATX(UBRR, CATX(SPI_UART, L))
+#define _SPI_UBRRH  CATX(UBRR, CATX(SPI_UART, H))
+#define _SPI_UDR    CATX(UDR,  SPI_UART)
+#define _SPI_UDRE   CATX(UDRE, SPI_UART)
+#define _SPI_RXCIE  CATX(RXCIE, SPI_UART)
+#define _SPI_RXEN   CATX(RXEN, SPI_UART)
+#define _SPI_TXEN   CATX(TXEN, SPI_UART)
+#define _SPI_UMSEL1 CATX(UMSEL, CATX(SPI_UART, 1))
+#define _SPI_UMSEL0 CATX(UMSEL, CATX(SPI_UART, 0))
+#define _SPI_UDORD  CATX(UDORD, SPI_UART)
+#define _SPI_UCPHA  CATX(UCPHA, SPI_UART)
+#define _SPI_UCPOL  CATX(UCPOL, SPI_UART)
+#define _SPI_XCK    CATX(SPI_XCK, SPI_UART)
+#define _SPI_RX_vect CATX(USART, CATX(SPI_UART, _RX_vect))
+#endif
+
+extern struct spi_xfer * volatile _spi_head;
+extern struct spi_xfer *_spi_tail;
+extern u16 _spi_pos;  /* bytes received of the current transfer */
+extern u16 _spi_sent; /* bytes written, MSPIM only */
+
+void _spi_start(struct spi_xfer *x);
+
+static inline void _spi_init(u16 div, u08 mode)
+{
+	port_optimize_declare();
+#ifdef SPI_UART
+	_SPI_UBRRH = 0; /* must be 0 while the transmitter is enabled, see the datasheet */
+	_SPI_UBRRL = 0;
+	set_pin_directions(
+		set_pin_output(_SPI_XCK);
+	);
+	_SPI_UCSRC = _BV(_SPI_UMSEL1) | _BV(_SPI_UMSEL0)
+		| ((mode & SPI_LSB_FIRST) ? _BV(_SPI_UDORD) : 0)
+		| ((mode & 1) ? _BV(_SPI_UCPHA) : 0)
+		| ((mode & 2) ? _BV(_SPI_UCPOL) : 0);
+	_SPI_UCSRB = _BV(_SPI_RXCIE) | _BV(_SPI_RXEN) | _BV(_SPI_TXEN);
+	_SPI_UBRRH = (u08)((div / 2 - 1) >> 8);
+	_SPI_UBRRL = (u08)(div / 2 - 1);
+#else
+	/* SPR1:0 gives /4 /16 /64 /128, SPI2X halves all but the last */
+	u08 spr = div <= 2 ? 0x80 : div <= 4 ? 0 : div <= 8 ? 0x81 : div <= 16 ? 1 : div <= 32 ? 0x82 : div <= 64 ? 2 : 3;
+	write_pins_dir(
+		set_pin(SPI_SS); /* an input SS going low would drop us out of master mode */
+		set_pin_output(SPI_SS);
+		set_pin_output(SPI_MOSI);
+		set_pin_output(SPI_SCK);
+	);
+	SPCR = _BV(SPIE) | _BV(SPE) | _BV(MSTR) | (spr & 3)
+		| ((mode & SPI_LSB_FIRST) ? _BV(DORD) : 0)
+		| ((mode & 1) ? _BV(CPHA) : 0)
+		| ((mode & 2) ? _BV(CPOL) : 0);
+	SPSR = (spr & 0x80) ? _BV(SPI2X) : 0;
+#endif
+}
+
+/* queue a transfer, starting it if the bus is idle; may be called from interrupts too */
+static inline void _spi_submit(struct spi_xfer *x)
+{
+	x->next = 0;
+	x->state = SPI_QUEUED;
+	u08 sreg = SREG;
+	cli();
+	if (_spi_head)
+		_spi_tail->next = x;
+	else {
+		_spi_head = x;
+		_spi_start(x);
+	}
+	_spi_tail = x;
+	SREG = sreg;
+}
+
+#ifdef MAIN /* define ISRs in just one .c file */
+
+struct spi_xfer * volatile _spi_head;
+struct spi_xfer *_spi_tail;
+u16 _spi_pos;
+u16 _spi_sent;
+
+void _spi_start(struct spi_xfer *x) /* interrupts masked */
+{
+	x->state = SPI_BUSY;
+	if (x->cs)
+		x->cs(1);
+	_spi_pos = 0;
+#ifdef SPI_UART
+	_SPI_UDR = x->tx ? x->tx[0] : SPI_FILL;
+	_spi_sent = 1;
+	if (x->len > 1) { /* one more behind it, UDR frees up as soon as the first byte moves to the shifter */
+		while (!(_SPI_UCSRA & _BV(_SPI_UDRE)));
+		_SPI_UDR = x->tx ? x->tx[1] : SPI_FILL;
+		_spi_sent = 2;
+	}
+#else
+	SPDR = x->tx ? x->tx[0] : SPI_FILL;
+#endif
+}
+
+static inline void _spi_finish(struct spi_xfer *x) /* called from interrupt */
+{
+	struct spi_xfer *next = x->next;
+	if (x->cs)
+		x->cs(0);
+	_spi_head = next;
+	if (next)
+		_spi_start(next); /* keep the bus busy while the completion runs */
+	x->state = SPI_DONE;
+	if (!x->done)
+		return;
+#ifdef SPI_USE_DPC
+	if (x->flags & SPI_DPC)
+		dpc_post(x->done, x->param);
+	else
+#endif
+		x->done(x->param);
+}
+
+#ifdef SPI_UART
+ISR(_SPI_RX_vect) /* byte shifted in */
+{
+	struct spi_xfer *x = _spi_head;
+	u16 sent = _spi_sent;
+	u08 c = _SPI_UDR;
+	if (sent < x->len) { /* refill first, the shifter is running on the byte queued before */
+		_SPI_UDR = x->tx ? x->tx[sent] : SPI_FILL;
+		_spi_sent = sent + 1;
+	}
+	u16 pos = _spi_pos;
+	if (x->rx)
+		x->rx[pos] = c;
+	if (++pos < x->len) {
+		_spi_pos = pos;
+		return;
+	}
+	_spi_finish(x);
+}
+#else
+ISR(SPI_STC_vect) /* byte shifted in */
+{
+	struct spi_xfer *x = _spi_head;
+	u16 pos = _spi_pos;
+	u08 c = SPDR;
+	if (++pos < x->len) {
+		SPDR = x->tx ? x->tx[pos] : SPI_FILL; /* restart the bus before storing */
+		_spi_pos = pos;
+		if (x->rx)
+			x->rx[pos - 1] = c;
+		return;
+	}
+	if (x->rx)
+		x->rx[pos - 1] = c;
+	_spi_finish(x);
+}
+#endif
+
+#endif /* MAIN */
+
+#undef _spi_head
+#undef _spi_tail
+#undef _spi_pos
+#undef _spi_sent
+#undef _spi_init
+#undef _spi_submit
+#undef _spi_start
+#undef _spi_finish
+#ifdef SPI_UART
+#undef _SPI_UCSRA
+#undef _SPI_UCSRB
+#undef _SPI_UCSRC
+#undef _SPI_UBRRL
+#undef _SPI_UBRRH
+#undef _SPI_UDR
+#undef _SPI_UDRE
+#undef _SPI_RXCIE
+#undef _SPI_RXEN
+#undef _SPI_TXEN
+#undef _SPI_UMSEL1
+#undef _SPI_UMSEL0
+#undef _SPI_UDORD
+#undef _SPI_UCPHA
+#undef _SPI_UCPOL
+#undef _SPI_XCK
+#undef _SPI_RX_vect
+#endif
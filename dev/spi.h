@@ -0,0 +1,196 @@
+/*
+ * spi.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Queued, interrupt-driven SPI master driver, for the SPI port and for
+ * USARTs in master SPI mode
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SPI_H_
+#define _SPI_H_
+
+#include "avrutil.h"
+
+/*
+Usage:
+#define FLASH_CS_PRT B
+#define FLASH_CS_PIN 3
+#define FLASH_CS_POL 0
+SPI_CS_FUNC(flash_cs, FLASH_CS)  // chip select routine for transfers
+
+static u08 cmd[4], page[256];
+static struct spi_xfer rd = { .cs = flash_cs, .tx = cmd, .len = 4, ... };
+...
+spi_init(hw, 4, SPI_MODE0);      // SPI port, SCK = F_CPU / 4
+spi_submit(hw, &rd);             // returns at once
+...
+if (rd.state == SPI_DONE)        // or have rd.done called
+	...
+
+Each device is a token: hw is the SPI port, u0..u3 USART n in master SPI
+mode (MSPIM), enabled with the SPI_MSPIM bit mask. A USART used here
+must not be instantiated by serial.h as well (see SERIAL_UARTS).
+
+A transfer clocks len bytes (len >= 1) out of tx (SPI_FILL when tx is 0)
+and stores what comes back in rx (dropped when rx is 0), with cs(1)
+before the first byte and cs(0) after the last. Transfers are queued and
+run back to back from the interrupt; when one completes, the next one is
+started before done(param) is called, from the interrupt, or posted as
+a DPC if flags has SPI_DPC (needs SPI_USE_DPC and sys/dpc.h). The
+structure belongs to the driver from spi_submit until state is SPI_DONE.
+
+The SPI port interrupts once per byte, so at the fastest clocks the
+interrupt overhead dominates. USARTs in MSPIM mode have a transmit
+buffer and a two byte receive FIFO: the driver keeps the next byte
+queued behind the one being shifted, so bytes follow each other without
+gaps as long as the interrupt is served within a byte time.
+*/
+
+#ifndef SPI_FILL
+#define SPI_FILL 0xff
+#endif
+#ifndef SPI_MSPIM
+#define SPI_MSPIM 0 /* bit n set: USART n is an SPI master */
+#endif
+
+#define SPI_MODE0     0 /* CPOL 0, CPHA 0 */
+#define SPI_MODE1     1
+#define SPI_MODE2     2
+#define SPI_MODE3     3
+#define SPI_LSB_FIRST 4
+
+/* state */
+#define SPI_IDLE   0
+#define SPI_QUEUED 1
+#define SPI_BUSY   2
+#define SPI_DONE   3
+
+/* flags */
+#ifdef SPI_USE_DPC
+#define SPI_DPC    1 /* post done as a DPC instead of calling it from the interrupt */
+#else
+#define SPI_DPC    SPI_DPC_needs_SPI_USE_DPC /* a compile error, not a silent interrupt call */
+#endif
+
+struct spi_xfer {
+	struct spi_xfer *next;
+	void (*cs)(u08 on);     /* 0: no chip select */
+	const u08 *tx;
+	u08 *rx;
+	u16 len;
+	void (*done)(int);      /* 0: no notification, poll state */
+	int param;
+	u08 flags;
+	volatile u08 state;
+};
+
+/* chip select routine driving a pin function, polarity applied */
+#define SPI_CS_FUNC(name, func) \
+void name(u08 on) \
+{ \
+	port_optimize_declare(); \
+	if (on) \
+		set_pin(func); \
+	else \
+		clr_pin(func); \
+}
+
+#ifdef SPI_USE_DPC
+#include "sys/dpc.h"
+#endif
+
+/* SPI port pins, defaults for ATmega16/32/164/324/644/1284 */
+#ifndef SPI_SS_PRT
+#define SPI_SS_PRT B
+#define SPI_SS_PIN 4
+#define SPI_SS_POL 1
+#endif
+#ifndef SPI_MOSI_PRT
+#define SPI_MOSI_PRT B
+#define SPI_MOSI_PIN 5
+#define SPI_MOSI_POL 1
+#endif
+#ifndef SPI_SCK_PRT
+#define SPI_SCK_PRT B
+#define SPI_SCK_PIN 7
+#define SPI_SCK_POL 1
+#endif
+/* XCK pins for MSPIM, defaults for ATmega164/324/644/1284 */
+#ifndef SPI_XCK0_PRT
+#define SPI_XCK0_PRT B
+#define SPI_XCK0_PIN 0
+#define SPI_XCK0_POL 1
+#endif
+#ifndef SPI_XCK1_PRT
+#define SPI_XCK1_PRT D
+#define SPI_XCK1_PIN 4
+#define SPI_XCK1_POL 1
+#endif
+
+#ifdef SPDR
+#define SPI_DEV hw
+#include "spi-impl.h"
+#undef SPI_DEV
+#endif
+
+#if defined(UCSR0A) && (SPI_MSPIM & 0x01)
+#if defined(_SERIAL_H_)
+#error USART 0 is used by serial.h
+#endif
+#define SPI_DEV u0
+#define SPI_UART 0
+#include "spi-impl.h"
+#undef SPI_UART
+#undef SPI_DEV
+#endif
+#if defined(UCSR1A) && (SPI_MSPIM & 0x02)
+#if defined(_SERIAL_H_) && (SERIAL_UARTS & 0x02)
+#error USART 1 is used by serial.h, leave it out of SERIAL_UARTS
+#endif
+#define SPI_DEV u1
+#define SPI_UART 1
+#include "spi-impl.h"
+#undef SPI_UART
+#undef SPI_DEV
+#endif
+#if defined(UCSR2A) && (SPI_MSPIM & 0x04)
+#if defined(_SERIAL_H_) && (SERIAL_UARTS & 0x04)
+#error USART 2 is used by serial.h, leave it out of SERIAL_UARTS
+#endif
+#define SPI_DEV u2
+#define SPI_UART 2
+#include "spi-impl.h"
+#undef SPI_UART
+#undef SPI_DEV
+#endif
+#if defined(UCSR3A) && (SPI_MSPIM & 0x08)
+#if defined(_SERIAL_H_) && (SERIAL_UARTS & 0x08)
+#error USART 3 is used by serial.h, leave it out of SERIAL_UARTS
+#endif
+#define SPI_DEV u3
+#define SPI_UART 3
+#include "spi-impl.h"
+#undef SPI_UART
+#undef SPI_DEV
+#endif
+
+/* div: SCK = F_CPU / div; SPI port: 2, 4, ... 128; MSPIM: any even value up to 8192 */
+#define spi_init(dev, div, mode) CATX(_spi_init_, dev) (div, mode)
+#define spi_submit(dev, x) CATX(_spi_submit_, dev) (x)
+#define spi_busy(dev) (CATX(_spi_head_, dev) != 0)
+
+#endif
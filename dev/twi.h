@@ -0,0 +1,304 @@
+/*
+ * twi.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Queued, interrupt-driven TWI (I2C) master with timeouts and bus
+ * recovery
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _TWI_H_
+#define _TWI_H_
+
+#include "avrutil.h"
+#include "sys/hrt.h"
+
+/*
+Usage:
+static u08 reg = 0x00, temp[2];
+static struct twi_xfer rd = { .addr = 0x48, .wr = &reg, .wlen = 1, .rd = temp, .rlen = 2, .done = got_temp };
+...
+hrt_init();         // timeouts come from Timer1
+twi_init(400000);
+twi_submit(&rd);    // returns at once
+...
+void got_temp(int param)  // from the interrupt, or as a DPC with TWI_DPC
+{
+	if (rd.status == TWI_OK)
+		...
+}
+
+A transfer writes wlen bytes from wr, then, if rlen is not 0, reads
+rlen bytes into rd after a repeated start: START, SLA+W, wr..., [Sr,
+SLA+R, rd...,] STOP. wlen 0 gives a plain read, both 0 an address
+probe. Transfers are queued and run back to back (STOP and the next
+START are requested together). The structure belongs to the driver from
+twi_submit until state is TWI_DONE; status then holds the outcome.
+
+Every bus event must follow the previous one within TWI_TIMEOUT_US
+(long enough for the slowest clock stretching), measured with the
+Timer1 compare B unit, which this file owns. On a timeout the TWI is
+switched off, SCL is clocked by hand until the slave lets go of SDA, a
+STOP is generated and the transfer completes with TWI_TIMEOUT. That
+takes about 100us, in the interrupt. twi_recover() does the same from
+the main loop, e.g. at startup after a reset in the middle of a read.
+*/
+
+#ifndef TWI_TIMEOUT_US
+#define TWI_TIMEOUT_US 2000
+#endif
+#define TWI_RECOVER_US 5 /* half period of the recovery clock, 100kHz */
+
+/* bus pins, defaults for ATmega16/32/164/324/644/1284 */
+#ifndef TWI_SCL_PRT
+#define TWI_SCL_PRT C
+#define TWI_SCL_PIN 0
+#define TWI_SCL_POL 1
+#endif
+#ifndef TWI_SDA_PRT
+#define TWI_SDA_PRT C
+#define TWI_SDA_PIN 1
+#define TWI_SDA_POL 1
+#endif
+
+/* state */
+#define TWI_IDLE   0
+#define TWI_QUEUED 1
+#define TWI_BUSY   2
+#define TWI_DONE   3
+
+/* status */
+#define TWI_OK        0
+#define TWI_NACK_ADDR 1 /* no slave at addr */
+#define TWI_NACK_DATA 2 /* slave refused a written byte */
+#define TWI_BUS_ERROR 3 /* illegal START/STOP seen */
+#define TWI_TIMEOUT   4 /* bus stuck, recovered */
+
+/* flags */
+#ifdef TWI_USE_DPC
+#define TWI_DPC 1 /* post done as a DPC instead of calling it from the interrupt */
+#else
+#define TWI_DPC TWI_DPC_needs_TWI_USE_DPC /* a compile error, not a silent interrupt call */
+#endif
+
+struct twi_xfer {
+	struct twi_xfer *next;
+	u08 addr;              /* 7 bit */
+	const u08 *wr;
+	u08 wlen;
+	u08 *rd;
+	u08 rlen;
+	void (*done)(int);     /* 0: no notification, poll state */
+	int param;
+	u08 flags;
+	u08 status;
+	volatile u08 state;
+};
+
+#ifdef TWI_USE_DPC
+#include "sys/dpc.h"
+#endif
+
+#define _TWI_GO (_BV(TWINT) | _BV(TWEN) | _BV(TWIE))
+
+extern struct twi_xfer * volatile twi_head;
+extern struct twi_xfer *twi_tail;
+extern u08 twi_pos;
+extern u08 twi_reading;
+
+static inline void twi_init(u32 hz)
+{
+	TWSR = 0; /* prescaler 1 */
+	TWBR = (u08)((F_CPU / hz - 16) / 2);
+	TWCR = _BV(TWEN);
+}
+
+static inline void _twi_arm_timeout() /* interrupts masked */
+{
+	OCR1B = TCNT1 + HRT_US_TO_COUNTS(TWI_TIMEOUT_US);
+#ifdef TIFR1
+	TIFR1 = _BV(OCF1B);
+	TIMSK1 |= _BV(OCIE1B);
+#else
+	TIFR = _BV(OCF1B);
+	TIMSK |= _BV(OCIE1B);
+#endif
+}
+
+static inline void _twi_disarm_timeout()
+{
+#ifdef TIMSK1
+	TIMSK1 &= ~_BV(OCIE1B);
+#else
+	TIMSK &= ~_BV(OCIE1B);
+#endif
+}
+
+/* queue a transfer, starting it if the bus is idle; may be called from interrupts too */
+static inline void twi_submit(struct twi_xfer *x)
+{
+	x->next = 0;
+	x->state = TWI_QUEUED;
+	u08 sreg = SREG;
+	cli();
+	if (twi_head)
+		twi_tail->next = x;
+	else {
+		twi_head = x;
+		x->state = TWI_BUSY;
+		twi_pos = 0;
+		twi_reading = !x->wlen && x->rlen;
+		_twi_arm_timeout();
+		TWCR = _TWI_GO | _BV(TWSTA);
+	}
+	twi_tail = x;
+	SREG = sreg;
+}
+
+#define twi_busy() (twi_head != 0)
+
+/* release a slave stuck in the middle of a byte; TWI must be off */
+static inline void twi_recover()
+{
+	port_optimize_declare();
+	u08 i;
+	write_pins_dir( /* open drain: low = output 0, high = input, pulled up */
+		set_pin_input(TWI_SCL);
+		set_pin_input(TWI_SDA);
+		clr_pin_absolute(TWI_SCL);
+		clr_pin_absolute(TWI_SDA);
+	);
+	for (i = 0; i < 9 && !read_pin_absolute(TWI_SDA); i++) {
+		set_pin_output(TWI_SCL);
+		_delay_us(TWI_RECOVER_US);
+		set_pin_input(TWI_SCL);
+		_delay_us(TWI_RECOVER_US);
+	}
+	/* STOP: SDA rises while SCL is high */
+	set_pin_output(TWI_SDA);
+	_delay_us(TWI_RECOVER_US);
+	set_pin_input(TWI_SDA);
+	_delay_us(TWI_RECOVER_US);
+}
+
+#ifdef MAIN /* define ISRs in just one .c file */
+
+struct twi_xfer * volatile twi_head;
+struct twi_xfer *twi_tail;
+u08 twi_pos;
+u08 twi_reading;
+
+/* complete the current transfer, STOP and START the next one with one TWCR write */
+static void twi_finish(u08 status) /* called from interrupt */
+{
+	struct twi_xfer *x = twi_head;
+	struct twi_xfer *next = x->next;
+	twi_head = next;
+	if (next) {
+		next->state = TWI_BUSY;
+		twi_pos = 0;
+		twi_reading = !next->wlen && next->rlen;
+		_twi_arm_timeout();
+		TWCR = _TWI_GO | _BV(TWSTA) | (status != TWI_TIMEOUT ? _BV(TWSTO) : 0);
+	}
+	else {
+		_twi_disarm_timeout();
+		if (status != TWI_TIMEOUT)
+			TWCR = _TWI_GO | _BV(TWSTO);
+	}
+	x->status = status;
+	x->state = TWI_DONE;
+	if (!x->done)
+		return;
+#ifdef TWI_USE_DPC
+	if (x->flags & TWI_DPC)
+		dpc_post(x->done, x->param);
+	else
+#endif
+		x->done(x->param);
+}
+
+ISR(TWI_vect)
+{
+	struct twi_xfer *x = twi_head;
+	u08 pos = twi_pos;
+	_twi_arm_timeout(); /* progress */
+	switch (TWSR & 0xf8) {
+	case 0x08: /* START sent */
+	case 0x10: /* repeated START sent */
+		TWDR = (x->addr << 1) | twi_reading;
+		TWCR = _TWI_GO;
+		break;
+	case 0x18: /* SLA+W ACKed */
+	case 0x28: /* data ACKed */
+		if (pos < x->wlen) {
+			TWDR = x->wr[pos];
+			twi_pos = pos + 1;
+			TWCR = _TWI_GO;
+		}
+		else if (x->rlen) {
+			twi_reading = 1;
+			twi_pos = 0;
+			TWCR = _TWI_GO | _BV(TWSTA);
+		}
+		else
+			twi_finish(TWI_OK);
+		break;
+	case 0x38: /* arbitration lost, START again once the bus is free */
+		twi_reading = !x->wlen && x->rlen;
+		twi_pos = 0;
+		TWCR = _TWI_GO | _BV(TWSTA);
+		break;
+	case 0x40: /* SLA+R ACKed */
+		TWCR = (x->rlen > 1) ? (_TWI_GO | _BV(TWEA)) : _TWI_GO; /* NACK the last byte */
+		break;
+	case 0x50: /* data received, ACKed */
+		x->rd[pos++] = TWDR;
+		twi_pos = pos;
+		TWCR = ((u08)(pos + 1) < x->rlen) ? (_TWI_GO | _BV(TWEA)) : _TWI_GO;
+		break;
+	case 0x58: /* last byte received, NACKed */
+		x->rd[pos] = TWDR;
+		twi_finish(TWI_OK);
+		break;
+	case 0x20: /* SLA+W NACKed */
+	case 0x48: /* SLA+R NACKed */
+		twi_finish(TWI_NACK_ADDR);
+		break;
+	case 0x30: /* data NACKed */
+		twi_finish(TWI_NACK_DATA);
+		break;
+	default: /* 0x00 bus error */
+		twi_finish(TWI_BUS_ERROR);
+		break;
+	}
+}
+
+ISR(TIMER1_COMPB_vect) /* no bus event for TWI_TIMEOUT_US */
+{
+	struct twi_xfer *x = twi_head;
+	TWCR = 0;
+	twi_recover();
+	TWCR = _BV(TWEN);
+	if (x)
+		twi_finish(TWI_TIMEOUT);
+	else
+		_twi_disarm_timeout();
+}
+
+#endif /* MAIN */
+
+#endif
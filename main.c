@@ -12,6 +12,19 @@
 #define MAIN
 #include "avrutil.h"
 #include "dev/serial.h"
+#include "sys/idle.h"
+
+static volatile u08 test1_flag; /* TEST1 changed since the main loop last looked */
+
+static void test1_changed(int active) /* in the interrupt: only note it, the main loop reads the pin */
+{
+	test1_flag = 1;
+}
+
+#define PCINT_HANDLERS(on) \
+	on(TEST1, PCINT_BOTH, test1_changed)
+#define PCINT_GROUPS 0x01 /* TEST1 is on port A */
+#include "dev/pcint.h"
 
 int main(void)
 {
@@ -25,15 +38,20 @@ int main(void)
 	//serial_init(0, 115200, SERIAL_BITS_8, SERIAL_PARITY_NONE, SERIAL_STOP_BITS_1);
 	//serial_init(1, 115200, SERIAL_BITS_8, SERIAL_PARITY_NONE, SERIAL_STOP_BITS_1);
 
+	pcint_init();
+	sei();
+
     while (1) {
-		if (read_pin(TEST1))
-			set_pin(LED);
-		else
-			clr_pin(LED);
 		/*u08 x;
     	x = serial_getch(0);
     	serial_putch(0, x);
     	x = serial_getch(1);
     	serial_putch(1, x);*/
+		test1_flag = 0; /* before the read: a change after it sets the flag again */
+		if (read_pin(TEST1))
+			set_pin(LED);
+		else
+			clr_pin(LED);
+		idle_sleep_unless(test1_flag);
     }
 }
@@ -1,7 +1,80 @@
 #ifndef _SYS_DPC_H_
 #define _SYS_DPC_H_
 #include "avrutil.h"
+#include "sys/trace.h"
+#include "sys/lat.h"
+#ifdef LAT
+#include "sys/hrt.h"
+#endif
+
+/*
+Deferred procedure calls: ISRs (or the main loop) post fn(param), the
+main loop runs what has been posted with dpc_run(). Posts are queued in
+order in a sys/ring.h ring; a post that finds it full is counted in
+dpc_lost and dropped.
+*/
+
+#ifndef DPC_QUEUE
+#define DPC_QUEUE 16 /* slots, power of 2, up to 256; holds one less */
+#endif
+
+struct dpc {
+	void (*fn)(int);
+	int param;
+#ifdef LAT
+	u16 ts; /* Timer1 at dpc_post */
+#endif
+};
+
+#define RING_NAME dpc_q
+#define RING_TYPE struct dpc
+#define RING_SIZE DPC_QUEUE
+#include "sys/ring.h"
+
+extern u08 dpc_lost;
 
 void dpc_post(void (*fn)(int), int param);
 
+/* run everything posted so far, including what gets posted meanwhile; main loop only */
+static inline void dpc_run()
+{
+	struct dpc d;
+	while (dpc_q_pop(&d)) {
+#ifdef LAT
+		u16 t0 = hrt_now();
+		lat_add2(LAT_DPC_WAIT, t0 - d.ts, (u16)d.fn);
+		d.fn(d.param);
+		lat_add2(LAT_DPC_RUN, hrt_now() - t0, (u16)d.fn);
+#else
+		d.fn(d.param);
+#endif
+	}
+}
+
+#define dpc_pending() dpc_q_has_data()
+
+#ifdef MAIN
+u08 dpc_lost;
+
+void (dpc_post)(void (*fn)(int), int param)
+{
+	struct dpc d = { fn, param };
+	u08 sreg = SREG;
+	cli(); /* ISRs and the main loop all post: one producer at a time */
+#ifdef LAT
+	d.ts = TCNT1;
+#endif
+	if (!dpc_q_push(d) && dpc_lost != 0xff)
+		dpc_lost++;
+	SREG = sreg;
+}
+#endif
+
+#ifdef TRACE
+#define dpc_post(fn, param) do { \
+	trace2(TRACE_DPC_POST, (u08)(u16)(fn), (u08)((u16)(fn) >> 8)); \
+	(dpc_post)(fn, param); \
+} while (0)
+#endif
+
 #endif
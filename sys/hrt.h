@@ -0,0 +1,105 @@
+/*
+ * hrt.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * High resolution time: Timer/Counter1 free-running, for timestamps
+ * and short timeouts
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SYS_HRT_H_
+#define _SYS_HRT_H_
+
+#include "avrutil.h"
+#include "sys/trace.h"
+#include "sys/lat.h"
+
+/*
+Timer1 counts from 0 to 0xffff and wraps, it is never reloaded, so
+several users can share it: differences of hrt_now() values measure
+time, and the compare units can be pointed at hrt_now() + delay.
+@20MHz and /8 a count is 0.4us and the counter wraps every 26.2ms.
+
+Reading TCNT1 goes through the shared 16-bit TEMP register, so outside
+of ISRs read it only through hrt_now(), with interrupts masked.
+
+HRT_OVF_HOOK(), if defined before this file is included, runs in the
+overflow interrupt. With TRACE, every overflow is also traced.
+*/
+
+#ifndef HRT_PRESCALE
+#define HRT_PRESCALE 8
+#endif
+
+#if HRT_PRESCALE == 1
+#define HRT_CS (_BV(CS10))
+#elif HRT_PRESCALE == 8
+#define HRT_CS (_BV(CS11))
+#elif HRT_PRESCALE == 64
+#define HRT_CS (_BV(CS11) | _BV(CS10))
+#elif HRT_PRESCALE == 256
+#define HRT_CS (_BV(CS12))
+#else
+#error HRT_PRESCALE must be 1, 8, 64 or 256
+#endif
+
+/* whole counts, rounded up; keep the result under 0x8000 */
+#define HRT_US_TO_COUNTS(us) ((u16)(((u32)(F_CPU) / 1000 * (us) / 1000 + HRT_PRESCALE - 1) / HRT_PRESCALE))
+
+#ifndef HRT_OVF_HOOK
+#define HRT_OVF_HOOK()
+#endif
+
+extern volatile u16 hrt_ovf;
+
+static inline void hrt_init()
+{
+	TCCR1A = 0; /* normal mode */
+	TCNT1 = 0;
+	TCCR1B = HRT_CS;
+#ifdef TIMSK1
+	TIMSK1 |= _BV(TOIE1);
+#else
+	TIMSK |= _BV(TOIE1);
+#endif
+}
+
+static inline u16 hrt_now()
+{
+	u08 sreg = SREG;
+	cli();
+	u16 t = TCNT1;
+	SREG = sreg;
+	return t;
+}
+
+#ifdef MAIN /* define ISRs in just one .c file */
+
+volatile u16 hrt_ovf;
+
+ISR(TIMER1_OVF_vect)
+{
+	lat_add(LAT_HRT_OVF_IN, TCNT1); /* counts since the overflow */
+	lat_enter();
+	hrt_ovf++;
+	trace0(TRACE_HRT_OVF);
+	HRT_OVF_HOOK();
+	lat_exit(LAT_HRT_OVF);
+}
+
+#endif /* MAIN */
+
+#endif
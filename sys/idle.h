@@ -0,0 +1,113 @@
+/*
+ * idle.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Idle manager: put the MCU into the deepest sleep mode the enabled
+ * peripherals allow whenever the main loop has nothing to do
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SYS_IDLE_H_
+#define _SYS_IDLE_H_
+
+#include "avrutil.h"
+#include <avr/sleep.h>
+
+/*
+Usage, at the end of each main loop iteration:
+idle_sleep_unless(serial_has_rx_data(0) || timer_pending());
+
+The condition is evaluated with interrupts disabled and sleep follows
+sei immediately (the instruction after sei always executes before any
+interrupt), so an interrupt that creates work after the check cannot
+be lost: it is taken right after the sleep instruction and wakes us.
+Every interrupt ends the sleep, so the main loop runs again after each.
+
+The sleep mode is chosen from the peripheral registers at the time of
+the call, the deepest first:
+  power-down  nothing clocked is enabled - wake on pin change,
+              external interrupt, TWI address match or watchdog
+  power-save  only Timer2 runs, clocked asynchronously from TOSC
+  idle        any UART, SPI, TWI, ADC or synchronous timer enabled
+*/
+
+#define _IDLE_TIMER_ON(tccr) ((tccr) & (_BV(CS00) | _BV(CS01) | _BV(CS02)))
+
+static inline u08 idle_mode()
+{
+#ifdef UCSR0B
+	if (UCSR0B & (_BV(RXEN0) | _BV(TXEN0)))
+		return SLEEP_MODE_IDLE;
+#endif
+#ifdef UCSR1B
+	if (UCSR1B & (_BV(RXEN1) | _BV(TXEN1)))
+		return SLEEP_MODE_IDLE;
+#endif
+#if defined(UCSRB) && !defined(UCSR0B) /* single UART; serial.h leaves UCSRB aliased otherwise */
+	if (UCSRB & (_BV(RXEN) | _BV(TXEN)))
+		return SLEEP_MODE_IDLE;
+#endif
+#ifdef SPCR
+	if (SPCR & _BV(SPE))
+		return SLEEP_MODE_IDLE;
+#endif
+#ifdef TWCR
+	if (TWCR & _BV(TWEN))
+		return SLEEP_MODE_IDLE;
+#endif
+#ifdef ADCSRA
+	if (ADCSRA & _BV(ADEN))
+		return SLEEP_MODE_IDLE;
+#endif
+#ifdef TCCR0B
+	if (_IDLE_TIMER_ON(TCCR0B))
+		return SLEEP_MODE_IDLE;
+#elif defined(TCCR0)
+	if (_IDLE_TIMER_ON(TCCR0))
+		return SLEEP_MODE_IDLE;
+#endif
+	if (_IDLE_TIMER_ON(TCCR1B))
+		return SLEEP_MODE_IDLE;
+#ifdef TCCR2B
+	if (_IDLE_TIMER_ON(TCCR2B)) {
+#else
+	if (_IDLE_TIMER_ON(TCCR2)) {
+#endif
+#ifdef ASSR
+		if (ASSR & _BV(AS2)) {
+			/* writes to the async timer must reach it before we stop the I/O clock */
+			while (ASSR & (_BV(TCN2UB) | _BV(OCR2AUB) | _BV(OCR2BUB) | _BV(TCR2AUB) | _BV(TCR2BUB)));
+			return SLEEP_MODE_PWR_SAVE;
+		}
+#endif
+		return SLEEP_MODE_IDLE;
+	}
+	return SLEEP_MODE_PWR_DOWN;
+}
+
+#define idle_sleep_unless(cond) { \
+	cli(); \
+	if (!(cond)) { \
+		set_sleep_mode(idle_mode()); \
+		sleep_enable(); \
+		sei(); \
+		sleep_cpu(); \
+		sleep_disable(); \
+	} \
+	sei(); \
+}
+
+#endif
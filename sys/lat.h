@@ -0,0 +1,192 @@
+/*
+ * lat.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Latency histograms: interrupt entry delay and run time, deferred call
+ * wait and run time, timed on Timer1
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SYS_LAT_H_
+#define _SYS_LAT_H_
+
+#include "avrutil.h"
+
+/*
+Measurement points compile to nothing unless LAT is defined (for the
+whole build, e.g. CFLAGS += -DLAT), like sys/trace.h. Timer1 must run
+free (hrt_init()); everything is in its counts, 0.4us @20MHz and /8.
+
+Measured by the library:
+LAT_HRT_OVF_IN, LAT_TB_IN   Timer1 / Timer2 overflow until its ISR runs
+                            (read back from the timer itself; Timer2 in
+                            steps of TIMEBASE_PRESCALE cycles)
+LAT_HRT_OVF, LAT_TB         run time of those ISRs
+LAT_RX(n), LAT_UDRE(n), LAT_TXC(n)   run time of the UART n ISRs
+LAT_DPC_WAIT, LAT_DPC_RUN   dpc_post to start, and run time, of DPCs;
+                            the function behind the maximum is kept
+
+Application ISRs get slots from LAT_USER on (LAT_USER_SLOTS of them):
+#define LAT_ADC LAT_USER
+ISR(ADC_vect)
+{
+	lat_enter();
+	...
+	lat_exit(LAT_ADC);
+}
+...
+if (serial_getch(0) == 'L')
+	lat_dump();  // main loop; needs dev/serial.h
+host: tools/latdec.py -e main.elf /dev/ttyUSB1
+
+Each slot is a log2 histogram: bucket 0 counts zeros, bucket i values
+from 2^(i-1) to 2^i - 1, the last one everything above; plus the exact
+maximum. Adding a value takes a few dozen cycles with interrupts
+masked. ISR times do not include the vector jump and register pushes
+before lat_enter(), nor the pops after lat_exit().
+
+Stream format: 'H' slot nb max:16 who:16 count:16[nb] per used slot,
+then 'Z' nslots. who is the word address of the DPC function behind
+max, 0 elsewhere.
+*/
+
+#ifndef LAT_UARTS
+#define LAT_UARTS 2 /* UARTs 0..LAT_UARTS-1 are measured */
+#endif
+#ifndef LAT_USER_SLOTS
+#define LAT_USER_SLOTS 2
+#endif
+#ifndef LAT_BUCKETS
+#define LAT_BUCKETS 12 /* the last one holds >= 2^(LAT_BUCKETS-2) counts, 410us @0.4us */
+#endif
+
+/* slots */
+#define LAT_HRT_OVF_IN 0
+#define LAT_HRT_OVF    1
+#define LAT_TB_IN      2
+#define LAT_TB         3
+#define LAT_DPC_WAIT   4
+#define LAT_DPC_RUN    5
+#define LAT_RX(n)   ((n) < LAT_UARTS ? 6 + 3 * (n) : 0xff) /* 0xff: not measured */
+#define LAT_UDRE(n) ((n) < LAT_UARTS ? 7 + 3 * (n) : 0xff)
+#define LAT_TXC(n)  ((n) < LAT_UARTS ? 8 + 3 * (n) : 0xff)
+#define LAT_USER    (6 + 3 * LAT_UARTS)
+#define LAT_SLOTS   (LAT_USER + LAT_USER_SLOTS)
+
+#ifdef LAT
+
+#include <string.h>
+
+#ifndef LAT_UART
+#define LAT_UART 0
+#endif
+
+struct lat_hist {
+	u16 max;
+	u16 who;
+	u16 count[LAT_BUCKETS];
+};
+
+extern struct lat_hist lat_hist[LAT_SLOTS];
+
+__attribute__((always_inline)) static inline void lat_add2(u08 slot, u16 v, u16 who)
+{
+	if (slot >= LAT_SLOTS)
+		return;
+	u08 b = 0;
+	u16 x = v;
+	if (x >> 8) {
+		b = 8;
+		x >>= 8;
+	}
+	while (x) {
+		b++;
+		x >>= 1;
+	}
+	if (b > LAT_BUCKETS - 1)
+		b = LAT_BUCKETS - 1;
+	u08 sreg = SREG;
+	cli();
+	struct lat_hist *h = &lat_hist[slot];
+	if (h->count[b] != 0xffff)
+		h->count[b]++;
+	if (v > h->max) {
+		h->max = v;
+		h->who = who;
+	}
+	SREG = sreg;
+}
+
+#define lat_add(slot, v) lat_add2(slot, v, 0)
+
+/* ISRs only: TCNT1 is read without masking interrupts */
+#define lat_enter() u16 _lat_t0 = TCNT1
+#define lat_exit(slot) lat_add(slot, TCNT1 - _lat_t0)
+
+static inline void lat_reset()
+{
+	u08 sreg = SREG;
+	cli();
+	memset(lat_hist, 0, sizeof(lat_hist));
+	SREG = sreg;
+}
+
+/* send every slot that has seen a value, a consistent copy of each; main loop only, blocks */
+#define lat_dump() { \
+	u08 _lat_i, _lat_j; \
+	for (_lat_i = 0; _lat_i < LAT_SLOTS; _lat_i++) { \
+		struct lat_hist _lat_h; \
+		u08 _lat_sreg = SREG; \
+		cli(); \
+		_lat_h = lat_hist[_lat_i]; \
+		SREG = _lat_sreg; \
+		u16 _lat_n = 0; \
+		for (_lat_j = 0; _lat_j < LAT_BUCKETS; _lat_j++) \
+			_lat_n |= _lat_h.count[_lat_j]; \
+		if (!_lat_n) \
+			continue; \
+		serial_putch(LAT_UART, 'H'); \
+		serial_putch(LAT_UART, _lat_i); \
+		serial_putch(LAT_UART, LAT_BUCKETS); \
+		serial_putch(LAT_UART, (u08)_lat_h.max); \
+		serial_putch(LAT_UART, (u08)(_lat_h.max >> 8)); \
+		serial_putch(LAT_UART, (u08)_lat_h.who); \
+		serial_putch(LAT_UART, (u08)(_lat_h.who >> 8)); \
+		for (_lat_j = 0; _lat_j < LAT_BUCKETS; _lat_j++) { \
+			serial_putch(LAT_UART, (u08)_lat_h.count[_lat_j]); \
+			serial_putch(LAT_UART, (u08)(_lat_h.count[_lat_j] >> 8)); \
+		} \
+	} \
+	serial_putch(LAT_UART, 'Z'); \
+	serial_putch(LAT_UART, LAT_SLOTS); \
+}
+
+#ifdef MAIN
+struct lat_hist lat_hist[LAT_SLOTS];
+#endif
+
+#else /* LAT */
+
+#define lat_add2(slot, v, who)
+#define lat_add(slot, v)
+#define lat_enter()
+#define lat_exit(slot)
+#define lat_reset()
+#define lat_dump()
+
+#endif /* LAT */
+
+#endif
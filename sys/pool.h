@@ -0,0 +1,169 @@
+/*
+ * pool.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Fixed-block memory pools, instantiated per name, block size and
+ * block count
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+
+/*
+Include once per pool, like sys/ring.h:
+#define POOL_NAME msg
+#define POOL_BLOCK 64      // bytes per block
+#define POOL_COUNT 6       // blocks, up to 255
+#include "sys/pool.h"      // POOL_* are undefined again at the end
+
+gives (storage in the MAIN file):
+h = msg_alloc()      handle, 0 if the pool is empty
+msg_ptr(h)           the block, POOL_BLOCK bytes
+msg_free(h)
+msg_used, msg_high, msg_fail   blocks in use, most ever in use, failed allocs
+msg_bad              frees of a handle that is not allocated, ignored
+
+A handle is one byte, so blocks travel by reference: through a ring of
+u08 (sys/ring.h), as a DPC param, in a transfer structure. The owner of
+a handle is whoever holds it; a received frame can be filled by an ISR,
+posted to the main loop, answered in place and queued for sending, then
+freed by whoever sends it last, without copying the data.
+
+alloc and free are O(1) and mask interrupts for a few cycles, so both
+ISRs and the main loop may use them. Free blocks are chained through a
+link byte each; blocks never allocated yet are handed out in order, so
+no init call is needed. free ignores and counts a handle that was never
+handed out; built with POOL_DEBUG, each block also has a bit saying it is
+free, and freeing it twice is caught the same way instead of corrupting
+the chain. test/pool.cpp checks the counters and passes received lines
+from the RX hook to the main loop and back out in the same block.
+*/
+
+#include "avrutil.h"
+
+#if !defined(POOL_NAME) || !defined(POOL_BLOCK) || !defined(POOL_COUNT)
+#error define POOL_NAME, POOL_BLOCK and POOL_COUNT before including sys/pool.h
+#endif
+#if (POOL_COUNT) < 1 || (POOL_COUNT) > 255
+#error POOL_COUNT must be 1 to 255
+#endif
+
+/* vars */
+#define _pool_mem   CATX(POOL_NAME, _mem)
+#define _pool_link  CATX(POOL_NAME, _link)
+#define _pool_first CATX(POOL_NAME, _first)
+#define _pool_fresh CATX(POOL_NAME, _fresh)
+#define _pool_used  CATX(POOL_NAME, _used)
+#define _pool_high  CATX(POOL_NAME, _high)
+#define _pool_fail  CATX(POOL_NAME, _fail)
+#define _pool_bad   CATX(POOL_NAME, _bad)
+#define _pool_freed CATX(POOL_NAME, _freed)
+
+/* functions */
+#define _pool_alloc CATX(POOL_NAME, _alloc)
+#define _pool_free  CATX(POOL_NAME, _free)
+#define _pool_ptr   CATX(POOL_NAME, _ptr)
+
+extern u08 _pool_mem[POOL_COUNT][POOL_BLOCK];
+extern u08 _pool_link[POOL_COUNT]; /* next free handle, 0 ends the chain */
+extern u08 _pool_first;            /* first free handle */
+extern u08 _pool_fresh;            /* handles above this were never allocated */
+extern volatile u08 _pool_used;
+extern volatile u08 _pool_high;
+extern volatile u16 _pool_fail;
+extern volatile u08 _pool_bad;
+#ifdef POOL_DEBUG
+extern u08 _pool_freed[((POOL_COUNT) + 7) / 8]; /* bit h - 1: h is free */
+#endif
+
+static inline u08 *_pool_ptr(u08 h) { return _pool_mem[h - 1]; }
+
+static inline u08 _pool_alloc()
+{
+	u08 h;
+	u08 sreg = SREG;
+	cli();
+	h = _pool_first;
+	if (h) {
+		_pool_first = _pool_link[h - 1];
+#ifdef POOL_DEBUG
+		_pool_freed[(h - 1) >> 3] &= ~_BV((h - 1) & 7);
+#endif
+	}
+	else if (_pool_fresh < (POOL_COUNT))
+		h = ++_pool_fresh;
+	if (h) {
+		if (++_pool_used > _pool_high)
+			_pool_high = _pool_used;
+	}
+	else if (_pool_fail != 0xffff)
+		_pool_fail++;
+	SREG = sreg;
+	return h;
+}
+
+static inline void _pool_free(u08 h)
+{
+	u08 sreg = SREG;
+	cli();
+	if ((u08)(h - 1) >= _pool_fresh /* 0 or never handed out */
+#ifdef POOL_DEBUG
+		|| (_pool_freed[(h - 1) >> 3] & _BV((h - 1) & 7))
+#endif
+	) {
+		if (_pool_bad != 0xff)
+			_pool_bad++;
+	}
+	else {
+#ifdef POOL_DEBUG
+		_pool_freed[(h - 1) >> 3] |= _BV((h - 1) & 7);
+#endif
+		_pool_link[h - 1] = _pool_first;
+		_pool_first = h;
+		_pool_used--;
+	}
+	SREG = sreg;
+}
+
+#ifdef MAIN
+u08 _pool_mem[POOL_COUNT][POOL_BLOCK];
+u08 _pool_link[POOL_COUNT];
+u08 _pool_first;
+u08 _pool_fresh;
+volatile u08 _pool_used;
+volatile u08 _pool_high;
+volatile u16 _pool_fail;
+volatile u08 _pool_bad;
+#ifdef POOL_DEBUG
+u08 _pool_freed[((POOL_COUNT) + 7) / 8];
+#endif
+#endif
+
+#undef _pool_mem
+#undef _pool_link
+#undef _pool_first
+#undef _pool_fresh
+#undef _pool_used
+#undef _pool_high
+#undef _pool_fail
+#undef _pool_bad
+#undef _pool_freed
+#undef _pool_alloc
+#undef _pool_free
+#undef _pool_ptr
+
+#undef POOL_NAME
+#undef POOL_BLOCK
+#undef POOL_COUNT
@@ -0,0 +1,185 @@
+/*
+ * prof.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Sampling profiler: Timer0 periodically records the interrupted
+ * program counter, samples are streamed out over a UART and
+ * symbolised on the host by tools/profsym.py
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SYS_PROF_H_
+#define _SYS_PROF_H_
+
+#include "avrutil.h"
+#include "dev/serial.h"
+
+/*
+Usage:
+#define PROF_UART 1
+#include "sys/prof.h"
+...
+prof_start();
+while (1) {
+	...
+	prof_dump();
+}
+host: tools/profsym.py -e main.elf /dev/ttyUSB0
+
+Interrupts do not nest, so a sample that falls inside an ISR or a cli()
+section is taken only when interrupts are enabled again, and records
+that address instead. Such samples are recognised by how late they are
+(Timer0 has kept counting since the compare match) and flagged, so the
+report can tell "interrupts masked" time apart.
+
+Stream format: 'P' pc:16 per sample, pc is the word address, bit 15 set
+for late (masked) samples; 'L' n:16 when n samples were dropped because
+the buffer was full.
+*/
+
+#ifndef PROF_UART
+#define PROF_UART 0
+#endif
+#ifndef PROF_HZ
+#define PROF_HZ 2000
+#endif
+#ifndef PROF_BUF
+#define PROF_BUF 32 /* slots, power of 2, up to 256; holds one less sample */
+#endif
+#define PROF_PRESCALE 64
+#define PROF_LATE 2 /* Timer0 counts (of 64 cycles) past the match: interrupts were masked */
+#define PROF_LATE_FLAG 0x8000
+
+#if defined(__AVR_3_BYTE_PC__)
+#error prof.h handles 2-byte return addresses only
+#endif
+
+#define RING_NAME prof
+#define RING_TYPE u16
+#define RING_SIZE PROF_BUF
+#include "sys/ring.h"
+
+extern volatile u16 prof_lost;
+
+static inline void prof_start()
+{
+	TCCR0A = _BV(WGM01); /* CTC */
+	OCR0A = (u08)((u32)(F_CPU) / PROF_PRESCALE / PROF_HZ - 1);
+	TCNT0 = 0;
+	TCCR0B = _BV(CS01) | _BV(CS00); /* /64 */
+	TIMSK0 |= _BV(OCIE0A);
+}
+
+static inline void prof_stop()
+{
+	TIMSK0 &= ~_BV(OCIE0A);
+	TCCR0B = 0;
+}
+
+/* send what has been collected while the UART ring has room for whole records */
+static inline void prof_dump()
+{
+	u16 pc;
+	if (prof_lost && serial_tx_space(PROF_UART) >= 3) {
+		u08 sreg = SREG;
+		cli();
+		u16 n = prof_lost;
+		prof_lost = 0;
+		SREG = sreg;
+		serial_putch(PROF_UART, 'L');
+		serial_putch(PROF_UART, (u08)n);
+		serial_putch(PROF_UART, (u08)(n >> 8));
+	}
+	while (serial_tx_space(PROF_UART) >= 3 && prof_pop(&pc)) {
+		serial_putch(PROF_UART, 'P');
+		serial_putch(PROF_UART, (u08)pc);
+		serial_putch(PROF_UART, (u08)(pc >> 8));
+	}
+}
+
+#ifdef MAIN /* define ISRs in just one .c file */
+
+volatile u16 prof_lost;
+u16 prof_pc;
+u08 prof_cnt;
+
+/* a plain function, called from the vector below with the call-clobbered registers saved */
+void prof_tick(void) __attribute__((used, externally_visible));
+void prof_tick(void)
+{
+	u16 pc = prof_pc;
+	if (prof_cnt >= PROF_LATE)
+		pc |= PROF_LATE_FLAG;
+	if (!prof_push(pc) && prof_lost != 0xffff)
+		prof_lost++;
+}
+
+/* fetch the return address from under a known number of pushes, then
+   save what a C call may clobber (r0, r1, SREG, r18-r27, r30, r31), call
+   prof_tick and return from the interrupt */
+ISR(TIMER0_COMPA_vect, ISR_NAKED)
+{
+	__asm__ __volatile__ (
+		"push r0"              "\n\t"
+		"in r0, %[tcnt]"       "\n\t"
+		"sts prof_cnt, r0"     "\n\t"
+		"push r30"             "\n\t"
+		"push r31"             "\n\t"
+		"in r30, __SP_L__"     "\n\t"
+		"in r31, __SP_H__"     "\n\t"
+		"ldd r0, Z+4"          "\n\t" /* SP+1..3 are our pushes, then PCH, PCL */
+		"sts prof_pc+1, r0"    "\n\t"
+		"ldd r0, Z+5"          "\n\t"
+		"sts prof_pc, r0"      "\n\t"
+		"in r0, __SREG__"      "\n\t"
+		"push r0"              "\n\t"
+		"push r1"              "\n\t"
+		"clr __zero_reg__"     "\n\t"
+		"push r18"             "\n\t"
+		"push r19"             "\n\t"
+		"push r20"             "\n\t"
+		"push r21"             "\n\t"
+		"push r22"             "\n\t"
+		"push r23"             "\n\t"
+		"push r24"             "\n\t"
+		"push r25"             "\n\t"
+		"push r26"             "\n\t"
+		"push r27"             "\n\t"
+		"%~call prof_tick"     "\n\t"
+		"pop r27"              "\n\t"
+		"pop r26"              "\n\t"
+		"pop r25"              "\n\t"
+		"pop r24"              "\n\t"
+		"pop r23"              "\n\t"
+		"pop r22"              "\n\t"
+		"pop r21"              "\n\t"
+		"pop r20"              "\n\t"
+		"pop r19"              "\n\t"
+		"pop r18"              "\n\t"
+		"pop r1"               "\n\t"
+		"pop r0"               "\n\t"
+		"out __SREG__, r0"     "\n\t"
+		"pop r31"              "\n\t"
+		"pop r30"              "\n\t"
+		"pop r0"               "\n\t"
+		"reti"                 "\n\t"
+		:: [tcnt] "I" (_SFR_IO_ADDR(TCNT0))
+	);
+}
+
+#endif /* MAIN */
+
+#endif
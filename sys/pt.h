@@ -0,0 +1,147 @@
+/*
+ * pt.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Stackless cooperative threads (protothreads): each thread is a
+ * function re-entered from the main loop, resuming where it blocked
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SYS_PT_H_
+#define _SYS_PT_H_
+
+#include "avrutil.h"
+
+/*
+A thread costs 4 bytes of SRAM: the line it is blocked on and the tick
+it started waiting at. Threads have no stack of their own, so:
+* locals do not survive a wait - keep state in static variables or in a
+  struct that embeds the struct pt
+* a switch statement must not contain a wait (the waits are case labels)
+
+The timed waits use the timebase ticks, include sys/timebase.h to use
+them.
+
+Usage:
+char lcd_init_thread(struct pt *pt)
+{
+	static u08 i;
+	pt_begin(pt);
+	pt_delay(pt, TIMEBASE_MS_TO_TICKS(20));
+	for (i = 0; i < sizeof(init_seq); i++) {
+		lcd_cmd(init_seq[i]);
+		pt_delay(pt, TIMEBASE_MS_TO_TICKS(2));
+	}
+	pt_end(pt);
+}
+
+char reply_thread(struct pt *pt)
+{
+	pt_begin(pt);
+	serial_putch(0, '?');
+	pt_wait_timeout(pt, serial_has_rx_data(0), TIMEBASE_MS_TO_TICKS(100));
+	if (!serial_has_rx_data(0))
+		pt_restart(pt); // timed out, ask again
+	handle(serial_getch(0));
+	pt_end(pt);
+}
+
+struct pt lcd_pt, reply_pt;
+pt_init(&lcd_pt);
+pt_init(&reply_pt);
+while (1) {
+	timer_run();
+	lcd_init_thread(&lcd_pt);
+	reply_thread(&reply_pt);
+	idle_sleep_unless(timer_pending() || serial_has_rx_data(0));
+}
+*/
+
+struct pt {
+	u16 lc; /* resume point, 0: start */
+	u16 t;  /* tick a timed wait started at */
+};
+
+#define PT_WAITING 0
+#define PT_YIELDED 1
+#define PT_EXITED  2
+#define PT_ENDED   3
+
+#define pt_init(pt) ((pt)->lc = 0)
+
+#define pt_begin(pt) { \
+	char _pt_yield = 1; if (_pt_yield); \
+	switch ((pt)->lc) { case 0:
+
+#define pt_end(pt) \
+	} \
+	_pt_yield = 0; \
+	pt_init(pt); \
+	return PT_ENDED; \
+}
+
+#define _pt_set(pt) (pt)->lc = __LINE__; case __LINE__:
+
+#define pt_wait_until(pt, cond) do { \
+	_pt_set(pt) \
+	if (!(cond)) \
+		return PT_WAITING; \
+} while (0)
+
+#define pt_wait_while(pt, cond) pt_wait_until(pt, !(cond))
+
+/* give the other threads a turn */
+#define pt_yield(pt) do { \
+	_pt_yield = 0; \
+	_pt_set(pt) \
+	if (!_pt_yield) \
+		return PT_YIELDED; \
+} while (0)
+
+#define pt_yield_until(pt, cond) do { \
+	_pt_yield = 0; \
+	_pt_set(pt) \
+	if (!_pt_yield || !(cond)) \
+		return PT_YIELDED; \
+} while (0)
+
+#define pt_restart(pt) do { \
+	pt_init(pt); \
+	return PT_WAITING; \
+} while (0)
+
+#define pt_exit(pt) do { \
+	pt_init(pt); \
+	return PT_EXITED; \
+} while (0)
+
+/* run a child thread to completion */
+#define pt_spawn(pt, child, thread) do { \
+	pt_init(child); \
+	pt_wait_while(pt, (thread) < PT_EXITED); \
+} while (0)
+
+/* timed waits, in timebase ticks (at most 65535) */
+#define pt_elapsed(pt) ((u16)(timebase_ticks() - (pt)->t))
+
+#define pt_wait_timeout(pt, cond, ticks) do { \
+	(pt)->t = timebase_ticks(); \
+	pt_wait_until(pt, (cond) || pt_elapsed(pt) >= (ticks)); \
+} while (0)
+
+#define pt_delay(pt, ticks) pt_wait_timeout(pt, 0, ticks)
+
+#endif
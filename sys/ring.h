@@ -0,0 +1,170 @@
+/*
+ * ring.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Single producer, single consumer ring buffers, instantiated per name,
+ * element type and size
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+
+/*
+Include once per ring, like serial-impl.h is per UART:
+#define RING_NAME adcq
+#define RING_TYPE u16
+#define RING_SIZE 16       // power of 2, up to 256; holds RING_SIZE - 1
+#include "sys/ring.h"      // RING_* are undefined again at the end
+
+gives (storage in the MAIN file):
+adcq_push(x)         0 if full
+adcq_pop(&x)         0 if empty
+adcq_peek()          oldest element, has_data must be true
+adcq_push_n(src, n)  as many as fit, returns how many
+adcq_pop_n(dst, n)   as many as there are, returns how many
+adcq_count(), adcq_space(), adcq_has_data(), adcq_can_push()
+
+One side may be an ISR, the other the main loop (or another ISR), but
+each side must be one context at a time: with several producers, wrap
+the push in cli()/SREG restore. This is the serial driver's layout:
+head and tail are byte indexes, the slot is index & (RING_SIZE - 1), so
+no division, and one slot is kept free so head == tail always means
+empty; at 256 the byte wraparound alone does the masking. Indexes are
+single bytes, so loads and stores of them are atomic. Each side writes
+only its own index, once per call, after a barrier() so the element
+accesses cannot be moved past it. test/ring.cpp checks it (make check).
+*/
+
+#include "avrutil.h"
+
+#if !defined(RING_NAME) || !defined(RING_TYPE) || !defined(RING_SIZE)
+#error define RING_NAME, RING_TYPE and RING_SIZE before including sys/ring.h
+#endif
+#if (RING_SIZE) & ((RING_SIZE) - 1) || (RING_SIZE) > 256 || (RING_SIZE) < 2
+#error RING_SIZE must be a power of 2, 2 to 256
+#endif
+
+/* vars */
+#define _ring_buf       CATX(RING_NAME, _buf)
+#define _ring_head      CATX(RING_NAME, _head)
+#define _ring_tail      CATX(RING_NAME, _tail)
+
+/* functions */
+#define _ring_count     CATX(RING_NAME, _count)
+#define _ring_space     CATX(RING_NAME, _space)
+#define _ring_has_data  CATX(RING_NAME, _has_data)
+#define _ring_can_push  CATX(RING_NAME, _can_push)
+#define _ring_push      CATX(RING_NAME, _push)
+#define _ring_pop       CATX(RING_NAME, _pop)
+#define _ring_peek      CATX(RING_NAME, _peek)
+#define _ring_push_n    CATX(RING_NAME, _push_n)
+#define _ring_pop_n     CATX(RING_NAME, _pop_n)
+
+#define _RING_MASK ((u08)((RING_SIZE) - 1))
+
+#ifndef RING_INDEX
+#define RING_INDEX volatile u08 /* test/hx.h makes each access a point */
+#endif
+
+extern RING_TYPE _ring_buf[RING_SIZE];
+extern RING_INDEX _ring_head; /* written by the producer only */
+extern RING_INDEX _ring_tail; /* written by the consumer only */
+
+static inline u08 _ring_count() { return (u08)(_ring_head - _ring_tail) & _RING_MASK; }
+static inline u08 _ring_space() { return (u08)(_ring_tail - _ring_head - 1) & _RING_MASK; }
+static inline u08 _ring_has_data() { return _ring_head != _ring_tail; }
+static inline u08 _ring_can_push() { return ((u08)(_ring_head + 1) & _RING_MASK) != _ring_tail; }
+
+/* producer side */
+static inline u08 _ring_push(RING_TYPE x)
+{
+	u08 head = _ring_head;
+	u08 next = (u08)(head + 1) & _RING_MASK;
+	if (next == _ring_tail)
+		return 0;
+	_ring_buf[head] = x;
+	barrier();
+	_ring_head = next;
+	return 1;
+}
+
+static inline u08 _ring_push_n(const RING_TYPE *src, u08 n)
+{
+	u08 head = _ring_head;
+	u08 space = (u08)(_ring_tail - head - 1) & _RING_MASK;
+	u08 i;
+	if (n > space)
+		n = space;
+	for (i = 0; i < n; i++)
+		_ring_buf[(u08)(head + i) & _RING_MASK] = src[i];
+	barrier();
+	_ring_head = (u08)(head + n) & _RING_MASK;
+	return n;
+}
+
+/* consumer side */
+static inline u08 _ring_pop(RING_TYPE *x)
+{
+	u08 tail = _ring_tail;
+	if (tail == _ring_head)
+		return 0;
+	*x = _ring_buf[tail];
+	barrier();
+	_ring_tail = (u08)(tail + 1) & _RING_MASK;
+	return 1;
+}
+
+static inline RING_TYPE _ring_peek()
+{
+	return _ring_buf[_ring_tail];
+}
+
+static inline u08 _ring_pop_n(RING_TYPE *dst, u08 n)
+{
+	u08 tail = _ring_tail;
+	u08 count = (u08)(_ring_head - tail) & _RING_MASK;
+	u08 i;
+	if (n > count)
+		n = count;
+	for (i = 0; i < n; i++)
+		dst[i] = _ring_buf[(u08)(tail + i) & _RING_MASK];
+	barrier();
+	_ring_tail = (u08)(tail + n) & _RING_MASK;
+	return n;
+}
+
+#ifdef MAIN
+RING_TYPE _ring_buf[RING_SIZE];
+RING_INDEX _ring_head;
+RING_INDEX _ring_tail;
+#endif
+
+#undef _ring_buf
+#undef _ring_head
+#undef _ring_tail
+#undef _ring_count
+#undef _ring_space
+#undef _ring_has_data
+#undef _ring_can_push
+#undef _ring_push
+#undef _ring_pop
+#undef _ring_peek
+#undef _ring_push_n
+#undef _ring_pop_n
+#undef _RING_MASK
+
+#undef RING_NAME
+#undef RING_TYPE
+#undef RING_SIZE
@@ -0,0 +1,208 @@
+/*
+ * telem.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Compressed telemetry: per-channel deltas, zig-zag varint coded, sent
+ * in frames over a UART and decoded by tools/telemdec.py
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SYS_TELEM_H_
+#define _SYS_TELEM_H_
+
+#include "avrutil.h"
+#include "dev/serial.h"
+#include <util/crc16.h>
+
+/*
+Usage:
+#define TELEM_UART 1
+#define TELEM_CHANNELS 6
+#define TELEM_BATCH 8
+#include "sys/telem.h"
+...
+telem_set(0, adc);          // whenever a value is known
+telem_set(1, OCR1A);
+...
+telem_send();               // once per sample period, from the main loop
+host: tools/telemdec.py -b 115200 /dev/ttyUSB1 > log.csv
+
+Each telem_send() takes a sample of every channel; every TELEM_BATCH
+samples they go out as one frame:
+'T' hdr [n b] map[(n+3)/4] steps... crc8
+hdr bit 7 marks a key frame, bits 6..0 count frames. A key frame
+carries n and b (TELEM_BATCH) and codes its first samples against 0,
+so the decoder can start or resynchronise on it; one is sent every
+TELEM_KEY frames. Every other frame starts from the last sample of the
+one before. Each channel's b steps (differences from the sample
+before) are 16 bit, zig-zag mapped so small negative steps stay small
+(0, -1, 1, -2 -> 0, 1, 2, 3); map holds 2 bits per channel, channel 0
+in the low bits, saying how they are sent, channel after channel:
+TELEM_SAME  all 0, nothing sent
+TELEM_NIB   all below 16, two a byte, the first in the low nibble
+TELEM_VAR   7 bit groups low first, bit 7 set on all but the last
+crc8 is the CCITT CRC-8 of everything after 'T'.
+
+A noisy or slowly moving channel costs half a byte per sample and a
+still one nothing, against two raw; the header, map and CRC are paid
+once per batch. When the TX ring has no room for the whole frame the batch is
+dropped (telem_skipped) and the next one is coded against the same
+reference, so the decoder never sees a hole in the deltas, only a
+jump. A frame is at most 255 bytes, the most the TX ring can take.
+*/
+
+#ifndef TELEM_UART
+#define TELEM_UART 0
+#endif
+#ifndef TELEM_CHANNELS
+#define TELEM_CHANNELS 8 /* up to 64, as TELEM_FRAME_MAX allows */
+#endif
+#ifndef TELEM_BATCH
+#define TELEM_BATCH 8 /* samples per channel per frame */
+#endif
+#ifndef TELEM_KEY
+#define TELEM_KEY 8 /* frames between key frames */
+#endif
+
+#define TELEM_MAP ((TELEM_CHANNELS + 3) / 4)
+
+/* channel codes in the map */
+#define TELEM_SAME 0
+#define TELEM_NIB  1
+#define TELEM_VAR  2
+#define TELEM_FRAME_MAX (5 + TELEM_MAP + 3 * TELEM_CHANNELS * TELEM_BATCH)
+
+#if TELEM_FRAME_MAX > 255
+#error TELEM_CHANNELS * TELEM_BATCH too large for one frame through the TX ring
+#endif
+
+extern i16 telem_val[TELEM_CHANNELS];
+extern i16 telem_batch[TELEM_BATCH][TELEM_CHANNELS];
+extern i16 telem_ref[TELEM_CHANNELS]; /* last sample sent */
+extern u08 telem_n; /* samples in telem_batch */
+extern u08 telem_seq;
+extern u16 telem_skipped;
+
+#define telem_set(ch, v) (telem_val[ch] = (v))
+
+static inline u16 _telem_zigzag(u16 d)
+{
+	return (u16)(d << 1) ^ ((d & 0x8000) ? 0xffff : 0);
+}
+
+static inline u08 _telem_varint_len(u16 v)
+{
+	return v < 0x80 ? 1 : v < 0x4000 ? 2 : 3;
+}
+
+static inline void _telem_put(u08 c, u08 *crc)
+{
+	*crc = _crc8_ccitt_update(*crc, c);
+	serial_putch(TELEM_UART, c);
+}
+
+/* sample the current values, queue a frame when the batch is full; main loop only */
+static inline void telem_send()
+{
+	u08 map[TELEM_MAP];
+	u08 i, k, len, crc = 0;
+	u08 key = (telem_seq % TELEM_KEY) == 0;
+
+	for (i = 0; i < TELEM_CHANNELS; i++)
+		telem_batch[telem_n][i] = telem_val[i];
+	if (++telem_n < TELEM_BATCH)
+		return;
+	telem_n = 0;
+
+	/* sizing pass: how each channel goes, and how long the frame is */
+	len = 3 + (key ? 2 : 0) + TELEM_MAP;
+	for (i = 0; i < TELEM_MAP; i++)
+		map[i] = 0;
+	for (i = 0; i < TELEM_CHANNELS; i++) {
+		u16 prev = key ? 0 : (u16)telem_ref[i];
+		u16 top = 0;
+		u08 l = 0, code;
+		for (k = 0; k < TELEM_BATCH; k++) {
+			u16 z = _telem_zigzag((u16)telem_batch[k][i] - prev); /* wraps like the decoder's */
+			prev = (u16)telem_batch[k][i];
+			if (z > top)
+				top = z;
+			l += _telem_varint_len(z);
+		}
+		if (!top)
+			code = TELEM_SAME;
+		else if (top < 16) {
+			code = TELEM_NIB;
+			len += (TELEM_BATCH + 1) / 2;
+		}
+		else {
+			code = TELEM_VAR;
+			len += l;
+		}
+		map[i >> 2] |= code << ((i & 3) * 2);
+	}
+	if (serial_tx_space(TELEM_UART) < len) {
+		telem_skipped++;
+		return;
+	}
+
+	serial_putch(TELEM_UART, 'T');
+	_telem_put((telem_seq & 0x7f) | (key ? 0x80 : 0), &crc);
+	if (key) {
+		_telem_put(TELEM_CHANNELS, &crc);
+		_telem_put(TELEM_BATCH, &crc);
+	}
+	for (i = 0; i < TELEM_MAP; i++)
+		_telem_put(map[i], &crc);
+	for (i = 0; i < TELEM_CHANNELS; i++) {
+		u08 code = (map[i >> 2] >> ((i & 3) * 2)) & 3, nib = 0;
+		u16 prev = key ? 0 : (u16)telem_ref[i];
+		telem_ref[i] = telem_batch[TELEM_BATCH - 1][i];
+		if (code == TELEM_SAME)
+			continue;
+		for (k = 0; k < TELEM_BATCH; k++) {
+			u16 z = _telem_zigzag((u16)telem_batch[k][i] - prev);
+			prev = (u16)telem_batch[k][i];
+			if (code == TELEM_NIB) {
+				if (k & 1)
+					_telem_put(nib | (u08)(z << 4), &crc);
+				else
+					nib = (u08)z;
+				continue;
+			}
+			while (z >= 0x80) {
+				_telem_put((u08)z | 0x80, &crc);
+				z >>= 7;
+			}
+			_telem_put((u08)z, &crc);
+		}
+		if (code == TELEM_NIB && (TELEM_BATCH & 1))
+			_telem_put(nib, &crc);
+	}
+	serial_putch(TELEM_UART, crc);
+	telem_seq++;
+}
+
+#ifdef MAIN
+i16 telem_val[TELEM_CHANNELS];
+i16 telem_batch[TELEM_BATCH][TELEM_CHANNELS];
+i16 telem_ref[TELEM_CHANNELS];
+u08 telem_n;
+u08 telem_seq;
+u16 telem_skipped;
+#endif
+
+#endif
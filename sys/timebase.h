@@ -0,0 +1,165 @@
+/*
+ * timebase.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * System timebase: millisecond / microsecond counters and a tick
+ * counter, all driven by the Timer/Counter2 overflow interrupt
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SYS_TIMEBASE_H_
+#define _SYS_TIMEBASE_H_
+
+#include "avrutil.h"
+#include "sys/lat.h"
+#ifdef LAT
+#include "sys/hrt.h"
+#endif
+
+/*
+Timer2 runs free with the prescaler below; every overflow is one tick.
+@20MHz and /64 a tick is 819.2us. The millisecond counter is kept exact
+by carrying the remainder (in CPU cycles) from one overflow to the next,
+so there is no drift even though a tick is not a whole number of ms.
+
+Usage:
+timebase_init();
+sei();
+...
+u32 t0 = millis();
+...
+if (millis() - t0 >= 100)
+    do_stuff();
+*/
+
+#ifndef TIMEBASE_PRESCALE
+#define TIMEBASE_PRESCALE 64
+#endif
+
+#if TIMEBASE_PRESCALE == 1
+#define TIMEBASE_CS (_BV(CS20))
+#elif TIMEBASE_PRESCALE == 8
+#define TIMEBASE_CS (_BV(CS21))
+#elif TIMEBASE_PRESCALE == 32
+#define TIMEBASE_CS (_BV(CS21) | _BV(CS20))
+#elif TIMEBASE_PRESCALE == 64
+#define TIMEBASE_CS (_BV(CS22))
+#else
+#error TIMEBASE_PRESCALE must be 1, 8, 32 or 64
+#endif
+
+#define TIMEBASE_TICK_CYCLES ((u16)TIMEBASE_PRESCALE * 256) /* CPU cycles per tick */
+#define TIMEBASE_MS_CYCLES   ((u16)((u32)(F_CPU) / 1000))
+#define TIMEBASE_US_CYCLES   ((u16)((u32)(F_CPU) / 1000000))
+#define TIMEBASE_MS_INC      (TIMEBASE_TICK_CYCLES / TIMEBASE_MS_CYCLES)
+#define TIMEBASE_FRACT_INC   (TIMEBASE_TICK_CYCLES % TIMEBASE_MS_CYCLES)
+
+/* round up, so that waiting n ms never waits less */
+#define TIMEBASE_MS_TO_TICKS(ms) \
+	((u16)(((u32)(ms) * TIMEBASE_MS_CYCLES + TIMEBASE_TICK_CYCLES - 1) / TIMEBASE_TICK_CYCLES))
+
+extern volatile u32 tb_millis;
+extern volatile u16 tb_fract; /* CPU cycles past tb_millis */
+extern volatile u16 tb_ticks;
+
+static inline void timebase_init()
+{
+	TCNT2 = 0;
+#ifdef TCCR2B
+	TCCR2A = 0;
+	TCCR2B = TIMEBASE_CS;
+	TIMSK2 |= _BV(TOIE2);
+#else
+	TCCR2 = TIMEBASE_CS;
+	TIMSK |= _BV(TOIE2);
+#endif
+}
+
+#ifdef TIFR2
+#define _TIMEBASE_TIFR TIFR2
+#else
+#define _TIMEBASE_TIFR TIFR
+#endif
+
+/* tick count, wraps every 65536 ticks */
+static inline u16 timebase_ticks()
+{
+	u08 sreg = SREG;
+	cli();
+	u16 t = tb_ticks;
+	SREG = sreg;
+	return t;
+}
+
+static inline u32 millis()
+{
+	u08 sreg = SREG;
+	cli();
+	u32 m = tb_millis;
+	SREG = sreg;
+	return m;
+}
+
+static inline u32 micros()
+{
+	u08 sreg = SREG;
+	cli();
+	u32 m = tb_millis;
+	u16 f = tb_fract;
+	u08 t = TCNT2;
+	if ((_TIMEBASE_TIFR & _BV(TOV2)) && t < 255) { /* overflowed after cli, not counted yet */
+		m += TIMEBASE_MS_INC;
+		f += TIMEBASE_FRACT_INC;
+	}
+	SREG = sreg;
+	/* f < 1ms + 1 tick, fits 16 bits for the supported prescalers up to 32MHz */
+	f += (u16)t * TIMEBASE_PRESCALE;
+	return m * 1000 + f / TIMEBASE_US_CYCLES;
+}
+
+#ifdef MAIN /* define ISRs in just one .c file */
+
+#ifdef LAT /* TCNT2 at entry, in Timer1 counts */
+#if TIMEBASE_PRESCALE >= HRT_PRESCALE
+#define _TIMEBASE_LAT_IN() ((u16)TCNT2 * (TIMEBASE_PRESCALE / HRT_PRESCALE))
+#else
+#define _TIMEBASE_LAT_IN() (TCNT2 / (HRT_PRESCALE / TIMEBASE_PRESCALE))
+#endif
+#endif
+
+volatile u32 tb_millis;
+volatile u16 tb_fract;
+volatile u16 tb_ticks;
+
+ISR(TIMER2_OVF_vect)
+{
+	lat_add(LAT_TB_IN, _TIMEBASE_LAT_IN());
+	lat_enter();
+	u32 m = tb_millis + TIMEBASE_MS_INC;
+	u16 f = tb_fract + TIMEBASE_FRACT_INC;
+	if (f >= TIMEBASE_MS_CYCLES) {
+		f -= TIMEBASE_MS_CYCLES;
+		m++;
+	}
+	tb_millis = m;
+	tb_fract = f;
+	tb_ticks++;
+	lat_exit(LAT_TB);
+}
+
+#endif /* MAIN */
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * timer.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Software timers on top of the system timebase: hashed timer wheel,
+ * one-shot and periodic callbacks, O(1) arm and cancel
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SYS_TIMER_H_
+#define _SYS_TIMER_H_
+
+#include "avrutil.h"
+#include "sys/timebase.h"
+
+/*
+Timers hash into TIMER_WHEEL_SIZE slots by their expiry tick, so arming
+and cancelling is a list insert/unlink. timer_run() is called from the
+main loop; it catches up with the timebase one tick at a time and only
+visits the slot of that tick. Callbacks run in main loop context and
+have the same signature as dpc_post ones.
+
+Arm and cancel from the main loop only, not from interrupts. timer_run()
+must be called at least once every 65536 ticks.
+
+Usage:
+struct timer blink;
+void blink_fn(int param) { toggle_pin(LED); }
+...
+timer_init(&blink, &blink_fn, 0);
+timer_arm(&blink, TIMEBASE_MS_TO_TICKS(500), TIMEBASE_MS_TO_TICKS(500));
+while (1) {
+    timer_run();
+    ...
+}
+*/
+
+#ifndef TIMER_WHEEL_SIZE
+#define TIMER_WHEEL_SIZE 8 /* power of 2 */
+#endif
+
+struct timer {
+	struct timer *next;
+	struct timer **pprev; /* null when not armed */
+	u16 expires;
+	u16 period; /* 0: one-shot */
+	void (*fn)(int);
+	int param;
+};
+
+extern struct timer *timer_wheel[TIMER_WHEEL_SIZE];
+extern u16 timer_now;
+
+void timer_arm(struct timer *t, u16 ticks, u16 period);
+void timer_run();
+
+static inline void timer_init(struct timer *t, void (*fn)(int), int param)
+{
+	t->pprev = 0;
+	t->fn = fn;
+	t->param = param;
+}
+
+static inline bool timer_armed(struct timer *t) { return t->pprev != 0; }
+
+/* ticks left for timer_run() to process; call with interrupts disabled */
+static inline bool timer_pending() { return timer_now != tb_ticks; }
+
+static inline void timer_cancel(struct timer *t)
+{
+	if (t->pprev) {
+		*t->pprev = t->next;
+		if (t->next)
+			t->next->pprev = t->pprev;
+		t->pprev = 0;
+	}
+}
+
+#ifdef MAIN
+
+struct timer *timer_wheel[TIMER_WHEEL_SIZE];
+u16 timer_now;
+
+static void _timer_insert(struct timer *t)
+{
+	struct timer **slot = &timer_wheel[t->expires & (TIMER_WHEEL_SIZE - 1)];
+	t->next = *slot;
+	if (t->next)
+		t->next->pprev = &t->next;
+	t->pprev = slot;
+	*slot = t;
+}
+
+void timer_arm(struct timer *t, u16 ticks, u16 period)
+{
+	timer_cancel(t);
+	if (!ticks)
+		ticks = 1;
+	t->expires = timebase_ticks() + ticks;
+	t->period = period;
+	_timer_insert(t);
+}
+
+void timer_run()
+{
+	u16 ticks = timebase_ticks();
+	while (timer_now != ticks) {
+		u16 now = ++timer_now;
+		struct timer **slot = &timer_wheel[now & (TIMER_WHEEL_SIZE - 1)];
+		/* detach the slot: callbacks may arm into it or cancel anything */
+		struct timer *pending = *slot;
+		*slot = 0;
+		if (pending)
+			pending->pprev = &pending;
+		while (pending) {
+			struct timer *t = pending;
+			pending = t->next;
+			if (pending)
+				pending->pprev = &pending;
+			if (t->expires == now) {
+				t->pprev = 0;
+				if (t->period) {
+					t->expires = now + t->period;
+					_timer_insert(t);
+				}
+				t->fn(t->param);
+			}
+			else /* later round */
+				_timer_insert(t);
+		}
+	}
+}
+
+#endif /* MAIN */
+
+#endif
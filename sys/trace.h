@@ -0,0 +1,135 @@
+/*
+ * trace.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Binary event tracing: timestamped records in an SRAM ring, streamed
+ * out over a UART when idle and decoded by tools/tracedec.py
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _SYS_TRACE_H_
+#define _SYS_TRACE_H_
+
+#include "avrutil.h"
+
+/*
+Trace points compile to nothing unless TRACE is defined (for the whole
+build, e.g. CFLAGS += -DTRACE). When enabled, each one stores
+[event][arg a][arg b][Timer1 count] with interrupts masked for a few
+cycles; it is safe from ISRs and the main loop alike.
+
+#define TRACE_UART 1
+...
+hrt_init();
+...
+trace1(TRACE_USER + 3, x);
+...
+while (1) {
+	...
+	trace_flush();  // in idle time
+}
+host: tools/tracedec.py /dev/ttyUSB1
+
+Stream format: 'T' ev a b ts:16 per record, 'O' n when n records were
+dropped because the ring was full. Timer1 overflows are traced too, so
+the decoder can extend the timestamps past the 16 bit wrap.
+*/
+
+/* events; application events start at TRACE_USER */
+#define TRACE_HRT_OVF    0x01
+#define TRACE_DPC_POST   0x02 /* a, b: function word address */
+#define TRACE_WRITE_PINS 0x03 /* a, b: source line */
+#define TRACE_RX         0x10 /* + uart; a: byte stored, or b: 1 rx ring full (once per rx_ovf) */
+#define TRACE_UDRE       0x14 /* + uart; a: bytes fed */
+#define TRACE_TXC        0x18 /* + uart */
+#define TRACE_USER       0x40
+
+#define trace1(ev, a) trace2(ev, a, 0)
+#define trace0(ev) trace2(ev, 0, 0)
+
+#ifdef TRACE
+
+#ifndef TRACE_UART
+#define TRACE_UART 0
+#endif
+#ifndef TRACE_BUF
+#define TRACE_BUF 32 /* slots, power of 2, up to 256; holds one less record */
+#endif
+
+struct trace_rec {
+	u08 ev;
+	u08 a;
+	u08 b;
+	u16 ts;
+};
+
+/* every context produces, so pushes are made with interrupts masked */
+#define RING_NAME trace
+#define RING_TYPE struct trace_rec
+#define RING_SIZE TRACE_BUF
+#include "sys/ring.h"
+
+extern volatile u08 trace_lost;
+
+__attribute__((always_inline)) static inline void trace2(u08 ev, u08 a, u08 b)
+{
+	u08 sreg = SREG;
+	cli();
+	struct trace_rec r = { ev, a, b, TCNT1 };
+	if (!trace_push(r) && trace_lost != 0xff)
+		trace_lost++;
+	SREG = sreg;
+}
+
+/* send queued records while the UART ring has room for whole ones; main loop only */
+#define trace_flush() { \
+	struct trace_rec _r; \
+	if (trace_lost && serial_tx_space(TRACE_UART) >= 2) { \
+		u08 _trace_sreg = SREG; \
+		cli(); \
+		u08 _trace_n = trace_lost; \
+		trace_lost = 0; \
+		SREG = _trace_sreg; \
+		serial_putch(TRACE_UART, 'O'); \
+		serial_putch(TRACE_UART, _trace_n); \
+	} \
+	while (serial_tx_space(TRACE_UART) >= 6 && trace_pop(&_r)) { \
+		serial_putch(TRACE_UART, 'T'); \
+		serial_putch(TRACE_UART, _r.ev); \
+		serial_putch(TRACE_UART, _r.a); \
+		serial_putch(TRACE_UART, _r.b); \
+		serial_putch(TRACE_UART, (u08)_r.ts); \
+		serial_putch(TRACE_UART, (u08)(_r.ts >> 8)); \
+	} \
+}
+
+#ifdef MAIN
+volatile u08 trace_lost;
+#endif
+
+#undef TRACE_WRITE_PINS_POINT
+#define TRACE_WRITE_PINS_POINT() trace2(TRACE_WRITE_PINS, (u08)__LINE__, (u08)(__LINE__ >> 8))
+
+#include "sys/hrt.h" /* timestamps; includes this file too, either order works */
+
+#else /* TRACE */
+
+#define trace2(ev, a, b)
+#define trace_flush()
+
+#endif /* TRACE */
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * avr/io.h for host builds of the drivers, see test/hx.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _HOST_AVR_IO_H_
+#define _HOST_AVR_IO_H_
+
+#include "hx.h"
+
+#define _BV(bit) (1 << (bit))
+
+/* the ATmega324P subset the tests touch, UART 0 only */
+#define PORTA hx_r[HX_PORTA]
+#define PORTB hx_r[HX_PORTB]
+#define PORTC hx_r[HX_PORTC]
+#define PORTD hx_r[HX_PORTD]
+#define DDRA  hx_r[HX_DDRA]
+#define DDRB  hx_r[HX_DDRB]
+#define DDRC  hx_r[HX_DDRC]
+#define DDRD  hx_r[HX_DDRD]
+#define PINA  hx_r[HX_PINA]
+#define PINB  hx_r[HX_PINB]
+#define PINC  hx_r[HX_PINC]
+#define PIND  hx_r[HX_PIND]
+#define SREG  hx_r[HX_SREG]
+
+#define TCCR1A hx_r[HX_TCCR1A]
+#define TCCR1B hx_r[HX_TCCR1B]
+#define TIMSK1 hx_r[HX_TIMSK1]
+#define TIFR1  hx_r[HX_TIFR1]
+#define TCNT1  hx_tcnt1
+#define OCR1A  hx_ocr1a
+
+#define TCNT2  hx_r[HX_TCNT2]
+#define TCCR2A hx_r[HX_TCCR2A]
+#define TCCR2B hx_r[HX_TCCR2B]
+#define TIMSK2 hx_r[HX_TIMSK2]
+#define TIFR2  hx_r[HX_TIFR2]
+
+#define UCSR0A hx_r[HX_UCSR0A]
+#define UCSR0B hx_r[HX_UCSR0B]
+#define UCSR0C hx_r[HX_UCSR0C]
+#define UBRR0L hx_r[HX_UBRR0L]
+#define UBRR0H hx_r[HX_UBRR0H]
+#define UDR0   hx_r[HX_UDR0]
+
+#define RXC0   7
+#define TXC0   6
+#define UDRE0  5
+#define FE0    4
+#define DOR0   3
+#define UPE0   2
+#define U2X0   1
+#define MPCM0  0
+
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0  4
+#define TXEN0  3
+#define UCSZ02 2
+#define RXB80  1
+#define TXB80  0
+
+#define CS10   0
+#define CS11   1
+#define CS12   2
+#define TOIE1  0
+#define OCIE1A 1
+#define OCF1A  1
+#define CS20   0
+#define CS21   1
+#define CS22   2
+#define TOIE2  0
+#define TOV2   0
+
+#define UPM00  4
+#define USBS0  3
+#define UCSZ00 1
+
+#endif
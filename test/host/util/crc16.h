@@ -0,0 +1,51 @@
+/*
+ * util/crc16.h for host builds of the drivers, see test/hx.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _HOST_UTIL_CRC16_H_
+#define _HOST_UTIL_CRC16_H_
+
+/* as avr-libc documents them, in plain C */
+static inline uint8_t _crc8_ccitt_update(uint8_t crc, uint8_t data)
+{
+	int i;
+	crc ^= data;
+	for (i = 0; i < 8; i++)
+		crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+	return crc;
+}
+
+static inline uint16_t _crc16_update(uint16_t crc, uint8_t data)
+{
+	int i;
+	crc ^= data;
+	for (i = 0; i < 8; i++)
+		crc = crc & 1 ? (crc >> 1) ^ 0xa001 : crc >> 1;
+	return crc;
+}
+
+static inline uint16_t _crc_xmodem_update(uint16_t crc, uint8_t data)
+{
+	int i;
+	crc ^= (uint16_t)data << 8;
+	for (i = 0; i < 8; i++)
+		crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+	return crc;
+}
+
+#endif
@@ -0,0 +1,439 @@
+/*
+ * hx.h
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Host model of the registers, UART 0 and interrupts, to run the real
+ * drivers off-target and explore how interrupts can interleave with them
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#ifndef _HX_H_
+#define _HX_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Compiled as C++ so every register is an object: test/host/avr/io.h
+maps UCSR0A, SREG, PORTD... to hx_r[], and each read or write of one
+is a point where the model may act before the access goes through.
+cli(), sei(), barrier() and the sys/ring.h indexes (RING_INDEX) are
+points too. At a point:
+- an enabled and pending interrupt runs, if the I bit is set and no
+  interrupt is running (RX before UDRE before TXC, as on the chip); RX
+  at most once per point, as the chip runs an instruction of the main
+  program after each reti, so a vector that leaves RXC set does not
+  lock it out
+- in exploring mode, the UART may move a byte from UDR to the shifter,
+  finish shifting one, or receive the next byte of hx.in[] into UDR
+  when it is free; hx_choose() decides whether it does, so that
+  replaying with hx_next() visits every placement of these events
+  between the accesses of the code under test
+- in timed mode, HX_ACCESS_CYCLES pass and the UART follows the clock,
+  for throughput figures
+Interrupts only run between accesses, like between instructions. A
+finished frame sets TXC when UDR is empty; writing 1 to TXC clears it,
+as does entering the TXC vector. Writing UDR while it is full is a
+lost byte. Received bytes come from hx.in[] (hx_receive()) in
+exploring mode and hx_drain(), or the test sets hx.rx and hx.rxc and
+calls hx_point(); reading UDR clears RXC. A byte arriving while RXC is
+set (a hardware overrun) is not modelled: the line waits. With HX_BUS_REG/HX_BUS_BIT/HX_BUS_POL defined, the RS-485
+driver enable pin is watched: UDR written or a byte on the line while
+it is released is a failure.
+
+Usage:
+#include "hx.h"       // via avr/io.h, with -Itest/host
+...
+do {
+	hx_reset();
+	... run the code under test, hx_point() where the main loop idles
+	hx_drain();
+	hx_check(cond, "what went wrong");
+} while (hx_next());
+*/
+
+enum {
+	HX_PORTA, HX_PORTB, HX_PORTC, HX_PORTD,
+	HX_DDRA, HX_DDRB, HX_DDRC, HX_DDRD,
+	HX_PINA, HX_PINB, HX_PINC, HX_PIND,
+	HX_SREG,
+	HX_UCSR0A, HX_UCSR0B, HX_UCSR0C, HX_UBRR0L, HX_UBRR0H, HX_UDR0,
+	HX_TCCR1A, HX_TCCR1B, HX_TIMSK1, HX_TIFR1,
+	HX_TCNT2, HX_TCCR2A, HX_TCCR2B, HX_TIMSK2, HX_TIFR2,
+	HX_REGS
+};
+
+#define HX_I 0x80 /* SREG interrupt enable */
+
+#ifndef HX_FRAME_MIN
+#define HX_FRAME_MIN 3 /* a frame is at least 80 cycles (10 bits at F_CPU/8), longer than 3 accesses */
+#endif
+#ifndef HX_DEPTH
+#define HX_DEPTH 4096
+#endif
+#ifndef HX_WIRE
+#define HX_WIRE 4096
+#endif
+#ifndef HX_IN
+#define HX_IN 16
+#endif
+#define HX_ACCESS_CYCLES 2
+#define HX_ISR_CYCLES 20 /* vector, pushes, pops, reti */
+
+void hx_point(void);
+uint8_t hx_read(int r);
+void hx_write(int r, uint8_t v);
+
+struct hx_reg {
+	int r;
+	operator uint8_t() const { return hx_read(r); }
+	hx_reg &operator=(int v) { hx_write(r, v); return *this; }
+	hx_reg &operator=(const hx_reg &o) { hx_write(r, (uint8_t)o); return *this; }
+	hx_reg &operator|=(int v) { hx_write(r, hx_read(r) | v); return *this; }
+	hx_reg &operator&=(int v) { hx_write(r, hx_read(r) & v); return *this; }
+	hx_reg &operator^=(int v) { hx_write(r, hx_read(r) ^ v); return *this; }
+};
+
+extern hx_reg hx_r[HX_REGS];
+
+/* a sys/ring.h index: loads and stores are points */
+struct hx_idx {
+	uint8_t v;
+	operator uint8_t() const { hx_point(); return v; }
+	hx_idx &operator=(int x) { hx_point(); v = x; return *this; }
+	hx_idx &operator=(const hx_idx &o) { uint8_t x = o; return *this = x; }
+};
+#define RING_INDEX hx_idx
+extern volatile uint16_t hx_tcnt1; /* TCNT1, set by the test, no points */
+extern volatile uint16_t hx_ocr1a; /* OCR1A, the test runs the compare vector */
+
+#define cli() (hx_point(), hx.reg[HX_SREG] &= ~HX_I)
+#define sei() (hx.reg[HX_SREG] |= HX_I, hx_point())
+#define barrier() hx_point()
+#define bool hx_bool /* avrutil.h typedefs its own */
+
+/* the vectors, defined by the drivers */
+void USART0_RX_vect(void);
+void USART0_UDRE_vect(void);
+void USART0_TX_vect(void);
+void TIMER1_OVF_vect(void);
+
+struct hx_state {
+	uint8_t reg[HX_REGS];
+	int udr_full;       /* UDR holds a byte for the shifter */
+	uint8_t udr;
+	int busy;           /* shifter sending shift */
+	uint8_t shift;
+	int age;            /* points since the shifter loaded, exploring mode */
+	int txc;
+	int rxc;            /* rx holds a received byte */
+	uint8_t rx;
+	uint8_t in[HX_IN];  /* bytes the line still delivers, hx_receive() */
+	int nin, inpos;
+	int rx_age;         /* points since the last byte was received, exploring mode */
+	int in_isr;
+	long isrs[3];       /* UDRE, TXC, RX vectors run */
+	int timed;
+	long now, shift_end, frame; /* cycles, timed mode */
+	long busy_cycles;
+	uint8_t wire[HX_WIRE]; /* bytes sent on the line */
+	int nwire;
+	const char *fail;
+};
+
+extern struct hx_state hx;
+
+/* exploring mode: returns which of n alternatives this run takes */
+int hx_choose(int n);
+/* set up the next schedule, 0 when every one has been run */
+int hx_next(void);
+long hx_runs(void);
+void hx_reset(void);
+/* queue bytes for the line to deliver */
+void hx_receive(const uint8_t *p, int n);
+/* run interrupts and the UART until the line is quiet and hx.in[] delivered,
+   or RXC stays pending */
+void hx_drain(void);
+void hx_check(int ok, const char *what);
+
+#ifdef HX_MAIN
+
+hx_reg hx_r[HX_REGS] = {
+	{HX_PORTA}, {HX_PORTB}, {HX_PORTC}, {HX_PORTD},
+	{HX_DDRA}, {HX_DDRB}, {HX_DDRC}, {HX_DDRD},
+	{HX_PINA}, {HX_PINB}, {HX_PINC}, {HX_PIND},
+	{HX_SREG},
+	{HX_UCSR0A}, {HX_UCSR0B}, {HX_UCSR0C}, {HX_UBRR0L}, {HX_UBRR0H}, {HX_UDR0},
+	{HX_TCCR1A}, {HX_TCCR1B}, {HX_TIMSK1}, {HX_TIFR1},
+};
+volatile uint16_t hx_tcnt1;
+volatile uint16_t hx_ocr1a;
+
+struct hx_state hx;
+
+static struct {
+	int pick[HX_DEPTH];
+	int n[HX_DEPTH];
+	int len, at;
+	long runs;
+} hx_dfs;
+
+int hx_choose(int n)
+{
+	int i = hx_dfs.at++;
+	if (i >= HX_DEPTH) {
+		fprintf(stderr, "schedule deeper than HX_DEPTH\n");
+		exit(2);
+	}
+	if (i >= hx_dfs.len) {
+		hx_dfs.pick[i] = 0;
+		hx_dfs.len = i + 1;
+	}
+	hx_dfs.n[i] = n;
+	return hx_dfs.pick[i];
+}
+
+int hx_next(void)
+{
+	hx_dfs.runs++;
+	hx_dfs.len = hx_dfs.at;
+	while (hx_dfs.len && hx_dfs.pick[hx_dfs.len - 1] + 1 >= hx_dfs.n[hx_dfs.len - 1])
+		hx_dfs.len--;
+	if (!hx_dfs.len)
+		return 0;
+	hx_dfs.pick[hx_dfs.len - 1]++;
+	return 1;
+}
+
+long hx_runs(void)
+{
+	return hx_dfs.runs;
+}
+
+void hx_check(int ok, const char *what)
+{
+	int i;
+	if (ok && !hx.fail)
+		return;
+	fprintf(stderr, "FAIL: %s\n", hx.fail ? hx.fail : what);
+	fprintf(stderr, "line:");
+	for (i = 0; i < hx.nwire; i++)
+		fprintf(stderr, " %02x", hx.wire[i]);
+	fprintf(stderr, "\nschedule (1: UART event before the access):");
+	for (i = 0; i < hx_dfs.at; i++)
+		fprintf(stderr, "%s%d", i % 64 ? "" : "\n  ", hx_dfs.pick[i]);
+	fprintf(stderr, "\n");
+	exit(1);
+}
+
+static void hx_violation(const char *what)
+{
+	if (!hx.fail)
+		hx.fail = what;
+}
+
+static int hx_bus_on(void)
+{
+#ifdef HX_BUS_REG
+	return ((hx.reg[HX_BUS_REG] >> HX_BUS_BIT) & 1) == HX_BUS_POL;
+#else
+	return 1;
+#endif
+}
+
+void hx_reset(void)
+{
+	int timed = hx.timed;
+	long frame = hx.frame;
+	memset(&hx, 0, sizeof(hx));
+	hx.timed = timed;
+	hx.frame = frame;
+	hx.reg[HX_SREG] = HX_I;
+	hx_dfs.at = 0;
+}
+
+static void hx_load(void)
+{
+	if (!hx_bus_on())
+		hx_violation("byte started with the bus released");
+	hx.shift = hx.udr;
+	hx.udr_full = 0;
+	hx.busy = 1;
+	hx.age = 0;
+	hx.shift_end = hx.now + hx.frame;
+}
+
+static void hx_finish(void)
+{
+	if (!hx_bus_on())
+		hx_violation("bus released before the byte was out");
+	if (hx.nwire < HX_WIRE)
+		hx.wire[hx.nwire++] = hx.shift;
+	hx.busy = 0;
+	hx.busy_cycles += hx.frame;
+	if (!hx.udr_full)
+		hx.txc = 1;
+}
+
+void hx_receive(const uint8_t *p, int n)
+{
+	memcpy(hx.in + hx.nin, p, n);
+	hx.nin += n;
+	hx.rx_age = HX_FRAME_MIN;
+}
+
+static void hx_rx_arrive(void)
+{
+	hx.rx = hx.in[hx.inpos++];
+	hx.rxc = 1;
+	hx.rx_age = 0;
+}
+
+static void hx_dispatch(void)
+{
+	int rx_ran = 0;
+	while (!hx.in_isr && (hx.reg[HX_SREG] & HX_I)) {
+		uint8_t b = hx.reg[HX_UCSR0B];
+		void (*vect)(void);
+		int k;
+		if ((b & (1 << 7)) && hx.rxc && !rx_ran) { /* RXCIE, RXC */
+			vect = USART0_RX_vect;
+			k = 2;
+			rx_ran = 1;
+		}
+		else if ((b & (1 << 5)) && !hx.udr_full) { /* UDRIE, UDRE */
+			vect = USART0_UDRE_vect;
+			k = 0;
+		}
+		else if ((b & (1 << 6)) && hx.txc) { /* TXCIE, TXC */
+			hx.txc = 0;
+			vect = USART0_TX_vect;
+			k = 1;
+		}
+		else
+			return;
+		if (++hx.isrs[k] > 100000) {
+			hx_violation("interrupt storm");
+			return;
+		}
+		hx.in_isr = 1;
+		hx.reg[HX_SREG] &= ~HX_I;
+		if (hx.timed)
+			hx.now += HX_ISR_CYCLES;
+		vect();
+		hx.reg[HX_SREG] |= HX_I;
+		hx.in_isr = 0;
+	}
+}
+
+void hx_point(void)
+{
+	if (hx.timed) {
+		hx.now += HX_ACCESS_CYCLES;
+		if (hx.busy && hx.now >= hx.shift_end)
+			hx_finish();
+		if (hx.udr_full && !hx.busy)
+			hx_load();
+		hx_dispatch();
+		return;
+	}
+	hx.age++;
+	hx.rx_age++;
+	for (;;) {
+		hx_dispatch();
+		if (!hx.rxc && hx.inpos < hx.nin && hx.rx_age >= HX_FRAME_MIN && hx_choose(2)) {
+			hx_rx_arrive();
+			continue;
+		}
+		if (hx.busy ? hx.age < HX_FRAME_MIN : !hx.udr_full)
+			return;
+		if (!hx_choose(2))
+			return;
+		if (hx.busy)
+			hx_finish();
+		else
+			hx_load();
+	}
+}
+
+void hx_drain(void)
+{
+	long n;
+	for (n = 0; n < 100000; n++) {
+		hx_dispatch();
+		if (hx.busy) {
+			if (hx.timed)
+				hx.now = hx.shift_end;
+			hx_finish();
+		}
+		else if (hx.udr_full)
+			hx_load();
+		else if (!hx.rxc && hx.inpos < hx.nin)
+			hx_rx_arrive();
+		else
+			return;
+	}
+	hx_violation("line never goes quiet");
+}
+
+uint8_t hx_read(int r)
+{
+	hx_point();
+	switch (r) {
+	case HX_UCSR0A:
+		return (hx.reg[r] & 0x03) | (hx.rxc ? 0x80 : 0) | (hx.txc ? 0x40 : 0) | (hx.udr_full ? 0 : 0x20);
+	case HX_UDR0:
+		hx.rxc = 0;
+		return hx.rx;
+	default:
+		return hx.reg[r];
+	}
+}
+
+void hx_write(int r, uint8_t v)
+{
+	hx_point();
+	switch (r) {
+	case HX_UCSR0A:
+		if (v & 0x40) /* TXC, write 1 to clear */
+			hx.txc = 0;
+		hx.reg[r] = v & 0x03; /* U2X, MPCM */
+		break;
+	case HX_UDR0:
+		if (hx.udr_full)
+			hx_violation("UDR written while full, byte lost");
+		if (!hx_bus_on())
+			hx_violation("UDR written with the bus released");
+		hx.udr = v;
+		hx.udr_full = 1;
+		break;
+	default:
+		hx.reg[r] = v;
+		break;
+	}
+#ifdef HX_BUS_REG
+	if (r == HX_BUS_REG && !hx_bus_on() && (hx.udr_full || hx.busy))
+		hx_violation("bus released while a byte is in UDR or the shifter");
+#endif
+	if (r == HX_SREG || r == HX_UCSR0B)
+		hx_dispatch(); /* newly enabled interrupts run before the next instruction */
+}
+
+#endif /* HX_MAIN */
+
+#endif
@@ -0,0 +1,233 @@
+/*
+ * modbus.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Runs dev/modbus.h on the host UART model: answers, CRC and gap
+ * rejection, end of frame timing, table bounds and broadcasts
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#define MAIN
+#define HX_MAIN
+#define SERIAL_UARTS 1
+#define MODBUS_UART 0
+#define MODBUS_BAUD 19200
+
+#include "avrutil.h"
+#define u16 uint16_t /* Timer1 differences wrap at 16 bits, as int does on the chip */
+#include "dev/modbus.h"
+
+/*
+Bytes arrive one character time apart on Timer1 (at()), which runs the
+compare vector when it passes OCR1A, as the chip would; replies go out
+through the UART model. Built for 8E1 (modbus) and 8N1 (modbus_8n1),
+whose character times must be 11 and 10 bits.
+*/
+
+#ifdef HX_8N1
+#define HX_NAME "modbus_8n1"
+#else
+#define HX_NAME "modbus"
+#endif
+
+static u16 hold[4], coil;
+static int reads, writes;
+
+static u16 get_hold(u16 addr)
+{
+	hx_check(addr < 4, "read outside the table entry");
+	reads++;
+	return hold[addr];
+}
+
+static u08 set_hold(u16 addr, u16 v)
+{
+	hx_check(addr < 4, "write outside the table entry");
+	writes++;
+	if (v == 0xdead)
+		return MODBUS_EX_VALUE;
+	hold[addr] = v;
+	return 0;
+}
+
+static u16 get_coil(u16 addr)
+{
+	hx_check(addr >= 10 && addr < 18, "coil read outside the table entry");
+	reads++;
+	return (coil >> (addr - 10)) & 1;
+}
+
+static u08 set_coil(u16 addr, u16 v)
+{
+	hx_check(addr >= 10 && addr < 18, "coil write outside the table entry");
+	writes++;
+	coil = (coil & ~(1 << (addr - 10))) | (v << (addr - 10));
+	return 0;
+}
+
+const struct modbus_regs modbus_table[] = {
+	{ MODBUS_HOLDING, 0, 4, get_hold, set_hold },
+	{ MODBUS_COILS, 10, 8, get_coil, set_coil },
+	{ 0 }
+};
+
+static uint16_t now; /* Timer1 */
+
+static void at(uint16_t t)
+{
+	while (now != t) {
+		hx_tcnt1 = ++now;
+		if (now == hx_ocr1a && (hx.reg[HX_TIMSK1] & _BV(OCIE1A))) {
+			hx.in_isr = 1;
+			hx.reg[HX_SREG] &= ~HX_I;
+			TIMER1_COMPA_vect();
+			hx.reg[HX_SREG] |= HX_I;
+			hx.in_isr = 0;
+			hx_point();
+		}
+	}
+}
+
+static uint16_t crc16(const u08 *p, int n)
+{
+	uint16_t crc = 0xffff;
+	while (n--)
+		crc = _crc16_update(crc, *p++);
+	return crc;
+}
+
+/* a request with its CRC, a character time apart, gap more counts before byte gap_at */
+static void send(const u08 *p, int n, int gap_at = -1, int gap = 0)
+{
+	u08 b[260];
+	int i;
+	memcpy(b, p, n);
+	uint16_t crc = crc16(b, n);
+	b[n] = crc;
+	b[n + 1] = crc >> 8;
+	for (i = 0; i < n + 2; i++) {
+		at(now + MODBUS_CHAR + (i == gap_at ? gap : 0));
+		hx.rx = b[i];
+		hx.rxc = 1;
+		hx_point();
+	}
+}
+
+/* silence until the frame ends; the reply must be want[], then its CRC, or nothing */
+static void reply(const u08 *want, int n, const char *what)
+{
+	int w0 = hx.nwire;
+	at(now + MODBUS_T35 - 1);
+	hx_drain();
+	hx_check(hx.nwire == w0, "answered before 3.5 characters of silence");
+	at(now + 1);
+	hx_drain();
+	if (!n) {
+		hx_check(hx.nwire == w0, what);
+		return;
+	}
+	uint16_t crc = crc16(want, n);
+	hx_check(hx.nwire == w0 + n + 2 && !memcmp(hx.wire + w0, want, n) &&
+		hx.wire[w0 + n] == (u08)crc && hx.wire[w0 + n + 1] == (u08)(crc >> 8), what);
+}
+
+#define REQ(...) { static const u08 _r[] = { __VA_ARGS__ }; send(_r, sizeof(_r)); }
+#define REQ_GAP(at, gap, ...) { static const u08 _r[] = { __VA_ARGS__ }; send(_r, sizeof(_r), at, gap); }
+#define REPLY(what, ...) { static const u08 _w[] = { __VA_ARGS__ }; reply(_w, sizeof(_w), what); }
+#define NO_REPLY(what) reply(0, 0, what)
+
+int main()
+{
+	u16 errors;
+
+	hx_check(MODBUS_CHAR == (MODBUS_PARITY == SERIAL_PARITY_NONE ? 1302 : 1432), "character time not 10 bits for 8N1, 11 with parity");
+	hx.timed = 1;
+	hx.frame = (MODBUS_PARITY == SERIAL_PARITY_NONE ? 10 : 11) * F_CPU / MODBUS_BAUD;
+	hx_reset();
+	modbus_addr = 17;
+	modbus_init();
+	hx_check(((hx.reg[HX_UCSR0C] >> UPM00) & 3) == MODBUS_PARITY, "parity not set up");
+	hold[0] = 0x1234;
+	hold[1] = 0x5678;
+	hold[3] = 0xbeef;
+
+	/* plain read, and the end of frame on time */
+	REQ(17, 3, 0, 0, 0, 4);
+	REPLY("read holding registers", 17, 3, 8, 0x12, 0x34, 0x56, 0x78, 0, 0, 0xbe, 0xef);
+	hx_check(modbus_frames == 1 && !modbus_errors, "frame not counted");
+
+	/* CRC */
+	errors = modbus_errors;
+	{
+		static const u08 r[] = { 17, 6, 0, 1, 0, 9, 0, 0 };
+		int i;
+		for (i = 0; i < 8; i++) {
+			at(now + MODBUS_CHAR);
+			hx.rx = r[i];
+			hx.rxc = 1;
+			hx_point();
+		}
+	}
+	NO_REPLY("answered a frame with a bad CRC");
+	hx_check(modbus_errors == errors + 1 && hold[1] == 0x5678 && !writes, "bad CRC not dropped");
+
+	/* a gap inside the frame: up to 1.5 characters, not more */
+	REQ_GAP(3, MODBUS_T15, 17, 3, 0, 3, 0, 1);
+	REPLY("gap of 1.5 characters not accepted", 17, 3, 2, 0xbe, 0xef);
+	errors = modbus_errors;
+	REQ_GAP(3, MODBUS_T15 + 1, 17, 3, 0, 3, 0, 1);
+	NO_REPLY("answered a frame with a gap over 1.5 characters");
+	hx_check(modbus_errors == errors + 1, "gap not counted");
+
+	/* bounds of the table entry, without 16 bit wraparound */
+	reads = 0;
+	REQ(17, 3, 0, 3, 0, 1);
+	REPLY("last register not readable", 17, 3, 2, 0xbe, 0xef);
+	REQ(17, 3, 0, 3, 0, 2);
+	REPLY("read past the end accepted", 17, 0x83, MODBUS_EX_ADDRESS);
+	REQ(17, 3, 0, 0, 0, 5);
+	REPLY("read longer than the entry accepted", 17, 0x83, MODBUS_EX_ADDRESS);
+	REQ(17, 3, 0xff, 0xff, 0, 2);
+	REPLY("read wrapping past 0xffff accepted", 17, 0x83, MODBUS_EX_ADDRESS);
+	REQ(17, 16, 0xff, 0xff, 0, 2, 4, 1, 2, 3, 4);
+	REPLY("write wrapping past 0xffff accepted", 17, 0x90, MODBUS_EX_ADDRESS);
+	hx_check(reads == 1 && !writes, "callbacks run for a rejected access");
+	REQ(17, 16, 0, 2, 0, 2, 4, 0xaa, 0x55, 0x55, 0xaa);
+	REPLY("write multiple registers", 17, 16, 0, 2, 0, 2);
+	hx_check(hold[2] == 0xaa55 && hold[3] == 0x55aa && writes == 2, "registers not written");
+
+	/* coils */
+	REQ(17, 15, 0, 10, 0, 8, 1, 0xa5);
+	REPLY("write multiple coils", 17, 15, 0, 10, 0, 8);
+	REQ(17, 5, 0, 11, 0xff, 0);
+	REPLY("write single coil", 17, 5, 0, 11, 0xff, 0);
+	REQ(17, 1, 0, 10, 0, 8);
+	REPLY("read coils", 17, 1, 1, 0xa7);
+
+	/* another slave's frame, broadcasts */
+	reads = writes = 0;
+	REQ(18, 6, 0, 0, 0, 1);
+	NO_REPLY("answered another address");
+	REQ(0, 3, 0, 0, 0, 4);
+	NO_REPLY("answered a broadcast");
+	hx_check(!reads, "broadcast read run");
+	REQ(0, 6, 0, 1, 0xab, 0xcd);
+	NO_REPLY("answered a broadcast");
+	hx_check(hold[1] == 0xabcd && writes == 1, "broadcast write not run");
+
+	printf(HX_NAME ": %u frames answered or broadcast, %u dropped, all as expected\n", modbus_frames, modbus_errors);
+	return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * pins.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Target-side check of avrutil.hpp: single pins and whole ports must
+ * compile to single sbi/cbi/out instructions (make check-avr)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#include "avrutil.hpp"
+
+/*
+Built with avr-g++ -Os; every function below may only contain sbi, cbi,
+out (with the ldi loading its value) and ret, which the pins-avr target
+checks on the disassembly.
+*/
+
+typedef avr::Pin<avr::PortA, 3, avr::ActiveHigh> Function1;
+typedef avr::Pin<avr::PortA, 6, avr::ActiveLow>  Function2;
+typedef avr::Pin<avr::PortB, 0>                  Led;
+typedef avr::Pin<avr::PortD, 7>                  Bus;
+
+void pin_set() { Function1::set(); }
+void pin_clr() { Function1::clr(); }
+void pin_set_low() { Function2::set(); }
+void pin_clr_low() { Function2::clr(); }
+void pin_output() { Led::output(); }
+void pin_input() { Led::input(); }
+
+/* one pin per port: one sbi/cbi each */
+void group_one_per_port()
+{
+	avr::write_pins<avr::Set<Function1>, avr::Clr<Led>, avr::Set<Bus>, avr::Output<Bus> >();
+}
+
+#define _PC(n) avr::Pin<avr::PortC, n>
+
+/* all 8 bits of PORTC and of DDRC (all outputs): one out each */
+void group_whole_port()
+{
+	avr::write_pins<avr::Set<_PC(0)>, avr::Clr<_PC(1)>, avr::Set<_PC(2)>, avr::Clr<_PC(3)>,
+		avr::Set<_PC(4)>, avr::Clr<_PC(5)>, avr::Set<_PC(6)>, avr::Clr<_PC(7)>,
+		avr::Output<_PC(0)>, avr::Output<_PC(1)>, avr::Output<_PC(2)>, avr::Output<_PC(3)>,
+		avr::Output<_PC(4)>, avr::Output<_PC(5)>, avr::Output<_PC(6)>, avr::Output<_PC(7)> >();
+}
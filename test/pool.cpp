@@ -0,0 +1,232 @@
+/*
+ * pool.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Checks sys/pool.h: allocation order, exhaustion, counters, bad and
+ * double frees, and a zero-copy line echo through the UART model
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#define MAIN
+#define HX_MAIN
+#define SERIAL_UARTS 1
+#define POOL_DEBUG
+
+#include "avrutil.h"
+
+#define POOL_NAME blk
+#define POOL_BLOCK 4
+#define POOL_COUNT 5
+#include "sys/pool.h"
+
+#define POOL_NAME line
+#define POOL_BLOCK 16
+#define POOL_COUNT 2
+#include "sys/pool.h"
+
+#define RING_NAME lines
+#define RING_TYPE u08
+#define RING_SIZE 4
+#include "sys/ring.h"
+
+static void rx_line(u08 c, u08 err);
+#define SERIAL_RX_HOOK0_USE 1
+#define SERIAL_RX_HOOK0(c, err) rx_line(c, err)
+#include "dev/serial.h"
+
+/*
+blk: handles come out 1 to 5 in order, then 0 with blk_fail counting;
+a freed handle is the next one handed out; frees of 0, of a handle past
+the pool and of one not handed out yet are ignored and counted in
+blk_bad, and so is a second free of the same handle. Then a random mix
+of allocs and frees against a model: no handle is given out twice, the
+blocks do not overlap, blk_used and blk_high follow the model.
+*/
+
+static void counters()
+{
+	u08 h[6];
+	int i;
+
+	for (i = 0; i < 5; i++) {
+		h[i] = blk_alloc();
+		hx_check(h[i] == i + 1, "fresh blocks not handed out in order");
+		hx_check(blk_used == i + 1 && blk_high == i + 1, "used or high-water wrong");
+	}
+	h[5] = blk_alloc();
+	hx_check(!h[5] && blk_fail == 1 && blk_used == 5, "empty pool not reported");
+	blk_free(h[1]);
+	blk_free(h[3]);
+	hx_check(blk_used == 3 && blk_high == 5, "free not counted");
+	hx_check(blk_alloc() == h[3] && blk_alloc() == h[1], "freed blocks not reused last in, first out");
+	hx_check(!blk_alloc() && blk_fail == 2, "empty pool not reported");
+
+	blk_free(0);
+	blk_free(6);
+	blk_free(255);
+	hx_check(blk_bad == 3 && blk_used == 5, "handle out of range accepted");
+	blk_free(h[2]);
+	blk_free(h[2]);
+	hx_check(blk_bad == 4 && blk_used == 4, "double free accepted");
+	hx_check(blk_alloc() == h[2] && !blk_alloc(), "double free corrupted the chain");
+	for (i = 0; i < 5; i++)
+		blk_free(h[i]);
+	hx_check(blk_used == 0 && blk_bad == 4, "pool not empty after freeing all");
+}
+
+static void counters_fresh()
+{
+	blk_first = blk_fresh = 0;
+	blk_used = blk_high = 0;
+	blk_fail = 0;
+	blk_bad = 0;
+	memset(blk_freed, 0, sizeof(blk_freed));
+	hx_check(blk_alloc() == 1, "first handle not 1");
+	blk_free(2); /* not handed out yet */
+	hx_check(blk_bad == 1 && blk_used == 1, "never allocated handle accepted");
+	blk_free(1);
+}
+
+static void random_mix()
+{
+	u08 held[5];
+	int n = 0, high = blk_high, bad = blk_bad, i, j, k;
+	unsigned seed = 1;
+
+	for (k = 0; k < 100000; k++) {
+		seed = seed * 1103515245 + 12345;
+		if ((seed >> 16) & 1) {
+			u08 h = blk_alloc();
+			if (n == 5) {
+				hx_check(!h, "alloc from an empty pool");
+				continue;
+			}
+			hx_check(h >= 1 && h <= 5, "handle out of range");
+			for (i = 0; i < n; i++)
+				hx_check(held[i] != h, "handle given out twice");
+			held[n++] = h;
+			if (n > high)
+				high = n;
+			memset(blk_ptr(h), h, 4);
+		}
+		else if (n) {
+			i = (seed >> 17) % n;
+			u08 h = held[i];
+			held[i] = held[--n];
+			for (j = 0; j < 4; j++)
+				hx_check(blk_ptr(h)[j] == h, "block overwritten through another handle");
+			blk_free(h);
+		}
+		hx_check(blk_used == n && blk_high == high, "used or high-water wrong");
+	}
+	hx_check(blk_bad == bad, "good free counted as bad");
+	while (n)
+		blk_free(held[--n]);
+}
+
+/*
+Zero-copy echo: the RX hook stores bytes into a line block from the
+interrupt and, at '\n', queues the handle on a ring; the main loop
+upper-cases the line in place, sends it from the same block and frees
+it. Two blocks: two lines may wait, a third is dropped and counted in
+line_fail while the pool is empty, and the next one after a free gets
+through again.
+*/
+
+static u08 rx_cur, rx_pos;
+static int dropped;
+
+static void rx_line(u08 c, u08 err)
+{
+	(void)err;
+	if (!rx_cur) {
+		rx_cur = line_alloc();
+		rx_pos = 0;
+		if (!rx_cur) {
+			dropped++;
+			return;
+		}
+	}
+	line_ptr(rx_cur)[rx_pos++] = c;
+	if (c == '\n' || rx_pos == 16) {
+		if (!lines_push(rx_cur))
+			line_free(rx_cur);
+		rx_cur = 0;
+	}
+}
+
+static void arrive(const char *s)
+{
+	hx_receive((const u08 *)s, strlen(s));
+	hx_drain();
+}
+
+static int echo()
+{
+	u08 h, i, c;
+	int n = 0;
+
+	while (lines_pop(&h)) {
+		u08 *p = line_ptr(h);
+		for (i = 0; i < 16; i++) {
+			c = p[i];
+			if (c >= 'a' && c <= 'z')
+				p[i] = c - 'a' + 'A';
+		}
+		for (i = 0; i < 16; i++) {
+			serial_putch(0, p[i]);
+			if (p[i] == '\n')
+				break;
+		}
+		line_free(h);
+		n++;
+	}
+	hx_drain();
+	return n;
+}
+
+static void handoff()
+{
+	hx_reset();
+	UCSR0B = _BV(RXCIE0) | _BV(TXCIE0) | _BV(RXEN0) | _BV(TXEN0);
+
+	arrive("hello\n");
+	hx_check(line_used == 1 && lines_count() == 1, "line not queued");
+	hx_check(echo() == 1 && hx.nwire == 6 && !memcmp(hx.wire, "HELLO\n", 6), "line not echoed");
+	hx_check(line_used == 0, "block not freed after sending");
+
+	hx_reset();
+	UCSR0B = _BV(RXCIE0) | _BV(TXCIE0) | _BV(RXEN0) | _BV(TXEN0);
+	arrive("ab\n");
+	arrive("cd\n");
+	arrive("ef\n");
+	hx_check(line_used == 2 && line_high == 2 && lines_count() == 2, "two lines not held");
+	hx_check(dropped == 3 && line_fail == 3, "third line not dropped");
+	hx_check(echo() == 2 && hx.nwire == 6 && !memcmp(hx.wire, "AB\nCD\n", 6), "held lines not echoed in order");
+	arrive("gh\n");
+	hx_check(echo() == 1 && hx.nwire == 9 && !memcmp(hx.wire + 6, "GH\n", 3), "line after a free not echoed");
+	hx_check(line_used == 0 && line_bad == 0, "blocks leaked or freed twice");
+}
+
+int main()
+{
+	counters();
+	counters_fresh();
+	random_mix();
+	handoff();
+	printf("pool: counters, bad frees, random mix and zero-copy echo ok\n");
+	return 0;
+}
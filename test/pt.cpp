@@ -0,0 +1,129 @@
+/*
+ * pt.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Steps a sys/pt.h thread through its waits, a yield, a timer wakeup
+ * and the timed waits on the Timer2 tick
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#define MAIN
+#define HX_MAIN
+
+#include "avrutil.h"
+#define u16 uint16_t /* tick arithmetic wraps at 16 bits, as int does on the chip */
+#include "sys/timer.h"
+#include "sys/pt.h"
+
+/*
+One call of the thread per main loop turn, after timer_run(), as in the
+sys/pt.h example. After each call the return value and the step the
+thread reached must be the expected ones: it blocks on a flag, yields
+once, waits for a timer callback, delays, then waits with a timeout,
+which it runs out of the first time round and beats the second. Started
+near the tick counter wrap so the timed waits cross it.
+*/
+
+/* no UART here, but the model links its vectors */
+void USART0_RX_vect(void) {}
+void USART0_UDRE_vect(void) {}
+void USART0_TX_vect(void) {}
+
+static struct pt pt;
+static struct timer alarm;
+static u08 go, woke;
+static int step;
+
+static void alarm_fn(int param)
+{
+	woke = param;
+}
+
+static char worker(struct pt *pt)
+{
+	pt_begin(pt);
+	step = 1;
+	pt_wait_until(pt, go);
+	step = 2;
+	pt_yield(pt);
+	step = 3;
+	timer_arm(&alarm, 5, 0);
+	pt_wait_until(pt, woke);
+	step = 4;
+	pt_delay(pt, 3);
+	step = 5;
+	pt_wait_timeout(pt, go == 2, 4);
+	step = go == 2 ? 6 : 7;
+	pt_end(pt);
+}
+
+static void tick()
+{
+	hx.in_isr = 1;
+	hx.reg[HX_SREG] &= ~HX_I;
+	TIMER2_OVF_vect();
+	hx.reg[HX_SREG] |= HX_I;
+	hx.in_isr = 0;
+}
+
+/* n loop turns, each after a tick when ticks is set */
+static void turns(int n, int ticks, char ret, int at, const char *what)
+{
+	while (n--) {
+		if (ticks)
+			tick();
+		timer_run();
+		char r = worker(&pt);
+		hx_check(r == ret && step == at, what);
+	}
+}
+
+static void once(int beat)
+{
+	go = woke = 0;
+	step = 0;
+	turns(3, 0, PT_WAITING, 1, "did not block on the flag");
+	go = 1;
+	turns(1, 0, PT_YIELDED, 2, "did not yield");
+	turns(1, 0, PT_WAITING, 3, "did not resume after the yield");
+	turns(4, 1, PT_WAITING, 3, "woke before the timer");
+	turns(1, 1, PT_WAITING, 4, "timer callback did not wake it");
+	hx_check(!timer_armed(&alarm), "alarm still armed");
+	turns(2, 1, PT_WAITING, 4, "delay too short");
+	turns(1, 1, PT_WAITING, 5, "delay too long");
+	if (beat) {
+		turns(2, 1, PT_WAITING, 5, "timed wait ended early");
+		go = 2;
+		turns(1, 0, PT_ENDED, 6, "condition did not end the timed wait");
+	}
+	else {
+		turns(3, 1, PT_WAITING, 5, "timed wait ended early");
+		turns(1, 1, PT_ENDED, 7, "timed wait did not time out");
+	}
+	hx_check(pt.lc == 0, "ended thread not back at the start");
+}
+
+int main()
+{
+	hx_reset();
+	tb_ticks = timer_now = 0xfffa;
+	timer_init(&alarm, alarm_fn, 1);
+	pt_init(&pt);
+	once(0);
+	once(1);
+	printf("pt: waits, yield, timer wakeup and timed waits ok\n");
+	return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * ring.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Randomised check of sys/ring.h against a plain queue, at the smallest,
+ * a middle and the largest size
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#define MAIN
+#define HX_MAIN
+
+#include "avrutil.h"
+
+#define RING_NAME r2
+#define RING_TYPE u08
+#define RING_SIZE 2
+#include "sys/ring.h"
+
+struct rec {
+	u08 a;
+	u16 b;
+};
+
+#define RING_NAME r16
+#define RING_TYPE struct rec
+#define RING_SIZE 16
+#include "sys/ring.h"
+
+#define RING_NAME r256
+#define RING_TYPE u08
+#define RING_SIZE 256
+#include "sys/ring.h"
+
+/*
+A million random calls per ring: push, pop, push_n and pop_n of up to
+twice the size (255 at most), peek, with count, space, has_data and
+can_push checked after each one. The ring must hold exactly size - 1 elements, hand them
+back in order and never lose, duplicate or invent one, through many
+wraps of both indexes.
+*/
+
+/* no UART here, but the model links its vectors */
+void USART0_RX_vect(void) {}
+void USART0_UDRE_vect(void) {}
+void USART0_TX_vect(void) {}
+
+static uint32_t rnd(void)
+{
+	static uint32_t x = 1;
+	x = x * 1103515245 + 12345;
+	return x >> 8;
+}
+
+static u08 make8(u16 n) { return (u08)(n * 40503u); }
+static u16 key8(u08 x) { return x; }
+static struct rec make_rec(u16 n) { struct rec r = { (u08)n, (u16)(n * 40503u) }; return r; }
+static u16 key_rec(struct rec r) { return r.b ^ r.a; }
+
+/* the model: serial numbers of the elements in the ring, oldest first */
+static u16 model[256];
+static int mfirst, mcount;
+
+static u16 front(void)
+{
+	return model[mfirst];
+}
+
+static void model_pop(void)
+{
+	mfirst = (mfirst + 1) % 256;
+	mcount--;
+}
+
+static void model_push(u16 n)
+{
+	model[(mfirst + mcount++) % 256] = n;
+}
+
+#define RING_CHECK(name, type, size, make, key) \
+static void check_ ## name(void) \
+{ \
+	type buf[2 * (size)], x; \
+	u16 next = 0; \
+	long i; \
+	int k, n, got, cap = (size) - 1; \
+	mfirst = mcount = 0; \
+	for (i = 0; i < 1000000; i++) { \
+		n = rnd() % (2 * (size) < 256 ? 2 * (size) : 256); /* counts are bytes */ \
+		switch (rnd() % 5) { \
+		case 0: \
+			got = name ## _push(make(next)); \
+			hx_check(got == (mcount < cap), #name ": push"); \
+			if (got) \
+				model_push(next++); \
+			break; \
+		case 1: \
+			got = name ## _pop(&x); \
+			hx_check(got == (mcount > 0), #name ": pop"); \
+			if (got) { \
+				hx_check(key(x) == key(make(front())), #name ": pop order"); \
+				model_pop(); \
+			} \
+			break; \
+		case 2: \
+			for (k = 0; k < n; k++) \
+				buf[k] = make(next + k); \
+			got = name ## _push_n(buf, n); \
+			hx_check(got == (n < cap - mcount ? n : cap - mcount), #name ": push_n"); \
+			for (k = 0; k < got; k++) \
+				model_push(next++); \
+			break; \
+		case 3: \
+			got = name ## _pop_n(buf, n); \
+			hx_check(got == (n < mcount ? n : mcount), #name ": pop_n"); \
+			for (k = 0; k < got; k++) { \
+				hx_check(key(buf[k]) == key(make(front())), #name ": pop_n order"); \
+				model_pop(); \
+			} \
+			break; \
+		case 4: \
+			if (mcount) \
+				hx_check(key(name ## _peek()) == key(make(front())), #name ": peek"); \
+			break; \
+		} \
+		hx_check(name ## _count() == mcount, #name ": count"); \
+		hx_check(name ## _space() == cap - mcount, #name ": space"); \
+		hx_check(name ## _has_data() == (mcount > 0), #name ": has_data"); \
+		hx_check(name ## _can_push() == (mcount < cap), #name ": can_push"); \
+	} \
+	printf("ring: " #name ", %u elements through, all in order\n", (unsigned)next); \
+}
+
+RING_CHECK(r2, u08, 2, make8, key8)
+RING_CHECK(r16, struct rec, 16, make_rec, key_rec)
+RING_CHECK(r256, u08, 256, make8, key8)
+
+int main()
+{
+	check_r2();
+	check_r16();
+	check_r256();
+	return 0;
+}
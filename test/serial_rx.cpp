@@ -0,0 +1,90 @@
+/*
+ * serial_rx.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Checks the receive ring of dev/serial-impl.h against every placement
+ * of the received bytes and the RX interrupt between its accesses
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#define MAIN
+#define HX_MAIN
+#define SERIAL_UARTS 1
+
+#include "dev/serial.h"
+
+/*
+Exploring: the line delivers msg[] while the main loop polls
+serial_has_rx_data() and takes bytes with serial_getch(), an idle point
+per turn. Every ring index and register access is a point where a byte
+may arrive and the RX vector run. Once with the ring empty, once with
+254 older bytes in it and one slot left, so that in some schedules the
+vector finds it full. Every schedule must hand over the older bytes and
+msg[] in order, once each, and leave the ring empty; rx_ovf must be set
+exactly when the vector ran and left a byte in UDR for want of room.
+*/
+
+static const u08 msg[] = { 0x31, 0x32, 0x33 };
+
+static void explore(int old)
+{
+	static u08 got[256 + sizeof(msg)];
+	int i, n, turn, want = old + sizeof(msg);
+	long full = 0, runs = hx_runs();
+
+	do {
+		hx_reset();
+		UCSR0B = _BV(RXCIE0) | _BV(TXCIE0) | _BV(RXEN0) | _BV(TXEN0);
+		for (i = 0; i < old; i++)
+			rxq0_buf[i] = 0x80 ^ i;
+		rxq0_tail = 0;
+		rxq0_head = old;
+		rx_ovf0 = rx_err0 = 0;
+		hx_receive(msg, sizeof(msg));
+
+		n = 0;
+		for (turn = 0; turn < 4; turn++) {
+			hx_point();
+			if (serial_has_rx_data(0))
+				got[n++] = serial_getch(0);
+		}
+		for (;;) {
+			hx_drain();
+			if (!serial_has_rx_data(0))
+				break;
+			hx_check(n < want, "more bytes than were sent");
+			got[n++] = serial_getch(0);
+		}
+
+		hx_check(n == want && hx.inpos == hx.nin && !hx.rxc, "bytes not received");
+		for (i = 0; i < old; i++)
+			hx_check(got[i] == (0x80 ^ i), "older bytes lost or reordered");
+		hx_check(!memcmp(got + old, msg, sizeof(msg)), "bytes lost, duplicated or reordered");
+		hx_check(!serial_has_rx_data(0), "bytes left in the ring");
+		hx_check(rx_ovf0 == (hx.isrs[2] > (long)sizeof(msg)), "full ring not flagged, or flagged when not full");
+		hx_check(rx_err0 == rx_ovf0, "error flag without a cause");
+		full += rx_ovf0;
+	} while (hx_next());
+	printf("serial_rx: %d older + %d bytes, %ld schedules (%ld with the ring full), all ok\n",
+		old, (int)sizeof(msg), hx_runs() - runs, full);
+}
+
+int main()
+{
+	explore(0);
+	explore(254);
+	return 0;
+}
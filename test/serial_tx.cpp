@@ -0,0 +1,141 @@
+/*
+ * serial_tx.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Checks the transmit ring of dev/serial-impl.h against every placement
+ * of the UART events and interrupts between its register accesses
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#define MAIN
+#define HX_MAIN
+#define SERIAL_UARTS 1
+
+#ifdef HX_BUS /* RS-485: driver enable on PD4, held from the first byte written until TXC */
+#define BUS_TXEN0_USE 1
+#define BUS_TXEN0_PRT D
+#define BUS_TXEN0_PIN 4
+#define BUS_TXEN0_POL 1
+#define HX_BUS_REG HX_PORTD
+#define HX_BUS_BIT 4
+#define HX_BUS_POL 1
+#endif
+
+#include "dev/serial.h"
+
+/*
+Exploring: the main loop sends msg[], with an idle point before each
+byte and after the last, so the line may drain in between or not; for
+each subset of msg[], those bytes are sent with interrupts masked, as
+from another ISR (a bridge). Every schedule must put msg[] on the line
+in order, once, and leave the ring empty with UDRIE off. With HX_BUS
+the driver enable must also be on for every byte and off at the end.
+Timed: a burst larger than the ring, then bytes slower than the line.
+*/
+
+#ifdef HX_BUS
+#define HX_NAME "serial_tx_bus"
+#else
+#define HX_NAME "serial_tx"
+#endif
+
+static const u08 msg[] = { 0x55, 0xa5, 0x0f };
+
+static void start(void)
+{
+	hx_reset();
+	txq0_head = txq0_tail = 0;
+	UCSR0B = _BV(RXCIE0) | _BV(TXCIE0) | _BV(RXEN0) | _BV(TXEN0);
+}
+
+static void finish(const u08 *sent, int n)
+{
+	hx_drain();
+	hx_check(hx.nwire == n && !memcmp(hx.wire, sent, n), "line differs from the bytes sent");
+	hx_check(txq0_head == txq0_tail, "bytes left in the ring");
+	hx_check(!(hx.reg[HX_UCSR0B] & _BV(UDRIE0)), "UDRIE left on");
+#ifdef HX_BUS
+	hx_check(!(hx.reg[HX_PORTD] & _BV(4)), "bus not released after the last byte");
+#endif
+}
+
+static void explore(void)
+{
+	u08 i, masked;
+	for (masked = 0; masked < _BV(sizeof(msg)); masked++) {
+		do {
+			start();
+			for (i = 0; i < sizeof(msg); i++) {
+				hx_point();
+				if (masked & _BV(i)) {
+					cli();
+					serial_putch(0, msg[i]);
+					sei();
+				}
+				else
+					serial_putch(0, msg[i]);
+			}
+			hx_point();
+			finish(msg, sizeof(msg));
+		} while (hx_next());
+	}
+	printf(HX_NAME ": %d bytes, %ld schedules, all ok\n", (int)sizeof(msg), hx_runs());
+}
+
+static void timed(long baud)
+{
+	static u08 sent[HX_WIRE];
+	int i, n = 0;
+	long t0, isrs;
+
+	hx.timed = 1;
+	hx.frame = 10 * F_CPU / baud;
+	start();
+
+	/* burst: the producer keeps the ring full, the line must never idle */
+	for (i = 0; i < 1000; i++) {
+		while (!serial_can_tx(0))
+			hx_point();
+		serial_putch(0, sent[n++] = (u08)(i * 7));
+	}
+	hx_drain();
+	double busy = (double)hx.busy_cycles / hx.now;
+
+	/* trickle: bytes further apart than a frame go straight to UDR */
+	isrs = hx.isrs[0];
+	for (i = 0; i < 100; i++) {
+		t0 = hx.now;
+		while (hx.now < t0 + 2 * hx.frame)
+			hx_point();
+		serial_putch(0, sent[n++] = (u08)i);
+	}
+	finish(sent, n);
+	isrs = hx.isrs[0] - isrs;
+
+	printf(HX_NAME ": %ld baud, burst of 1000: line busy %.1f%%; 100 spaced bytes: %ld UDRE interrupts\n",
+		baud, 100 * busy, isrs);
+	hx_check(busy > 0.99, "line idles while the ring has bytes");
+	hx_check(isrs == 0, "idle line not written directly");
+	hx.timed = 0;
+}
+
+int main()
+{
+	explore();
+	timed(115200);
+	timed(1000000);
+	return 0;
+}
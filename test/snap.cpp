@@ -0,0 +1,149 @@
+/*
+ * snap.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Checks the pin snapshot macros of avrutil.h on stubbed PINx: edges in
+ * logic terms, groups spread over several ports
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#define HX_MAIN
+
+#include "avrutil.h"
+
+/*
+Four inputs on three ports, both polarities. The test sets PINA, PINB
+and PIND between snap_pins blocks and checks what snap_rose, snap_fell,
+snap_changed, snap_get and get_pin report for each pin, that an edge is
+reported by one snapshot only, that other pins of the same port do not
+show up, that snap_match and snap_any_changed combine ports, and that a
+block leaves the ports it does not name alone.
+*/
+
+#define KEY_PRT A /* active low */
+#define KEY_PIN 3
+#define KEY_POL 0
+#define DOOR_PRT A
+#define DOOR_PIN 6
+#define DOOR_POL 1
+#define SW_PRT B
+#define SW_PIN 0
+#define SW_POL 1
+#define LIM_PRT D /* active low */
+#define LIM_PIN 7
+#define LIM_POL 0
+
+/* no UART here, but the model links its vectors */
+void USART0_RX_vect(void) {}
+void USART0_UDRE_vect(void) {}
+void USART0_TX_vect(void) {}
+
+static struct pin_snap s;
+
+static void pins(u08 a, u08 b, u08 d)
+{
+	hx.reg[HX_PINA] = a;
+	hx.reg[HX_PINB] = b;
+	hx.reg[HX_PIND] = d;
+}
+
+/* rose, fell, changed, level of one pin, as a digit each */
+#define EDGES(func) (snap_rose(s, func) * 1000 + snap_fell(s, func) * 100 + \
+	snap_changed(s, func) * 10 + snap_get(s, func))
+
+static void snap_all()
+{
+	port_optimize_declare();
+	snap_pins(s,
+		read_pin(KEY);
+		read_pin(DOOR);
+		read_pin(SW);
+		read_pin(LIM);
+	);
+	hx_check(get_pin(KEY) == snap_get(s, KEY) && get_pin(LIM) == snap_get(s, LIM),
+		"get_pin disagrees with snap_get after snap_pins");
+}
+
+static void snap_a()
+{
+	port_optimize_declare();
+	snap_pins(s,
+		read_pin(KEY);
+		read_pin(DOOR);
+	);
+}
+
+static void edges()
+{
+	pins(0x08, 0x00, 0x80); /* all inactive */
+	snap_all();
+	snap_all(); /* the startup snapshot */
+	hx_check(EDGES(KEY) == 0 && EDGES(DOOR) == 0 && EDGES(SW) == 0 && EDGES(LIM) == 0,
+		"edge or level reported with nothing active");
+
+	pins(0x00, 0x00, 0x80); /* KEY pressed: PA3 low */
+	snap_all();
+	hx_check(EDGES(KEY) == 1011, "active low pin going active not seen as a rise");
+	hx_check(EDGES(DOOR) == 0 && EDGES(SW) == 0 && EDGES(LIM) == 0, "edge on a pin that did not move");
+	snap_all();
+	hx_check(EDGES(KEY) == 1, "edge reported by a second snapshot");
+
+	pins(0x48, 0x00, 0x80); /* KEY released, DOOR open */
+	snap_all();
+	hx_check(EDGES(KEY) == 110 && EDGES(DOOR) == 1011, "fall or rise wrong on one port");
+
+	pins(0x48 | 0xb7, 0x00 | 0xfe, 0x80 | 0x7f); /* every other pin moves */
+	snap_all();
+	hx_check(EDGES(KEY) == 0 && EDGES(DOOR) == 1 && EDGES(SW) == 0 && EDGES(LIM) == 0,
+		"another pin of the port seen as an edge");
+}
+
+static void groups()
+{
+	pins(0x08, 0x00, 0x80);
+	snap_all();
+	snap_all();
+
+	pins(0x08, 0x01, 0x00); /* SW and LIM active, on B and D */
+	snap_all();
+	hx_check(snap_match(s, want_pin(SW, 1); want_pin(LIM, 1);), "group on two ports not matched");
+	hx_check(!snap_match(s, want_pin(SW, 1); want_pin(LIM, 0);), "group matched with a pin wrong");
+	hx_check(!snap_match(s, want_pin(SW, 1); want_pin(KEY, 1);), "group matched with a pin on another port wrong");
+	hx_check(snap_match(s, want_pin(SW, 1); want_pin(LIM, 1); want_pin(KEY, 0); want_pin(DOOR, 0);),
+		"group on three ports not matched");
+	hx_check(snap_any_changed(s, want_pin(KEY, 0); want_pin(LIM, 0);), "change on the second port missed");
+	hx_check(!snap_any_changed(s, want_pin(KEY, 0); want_pin(DOOR, 0);), "change seen on a still port");
+
+	snap_all();
+	hx_check(!snap_any_changed(s, want_pin(SW, 0); want_pin(LIM, 0);), "group change reported twice");
+	hx_check(snap_match(s, want_pin(SW, 1); want_pin(LIM, 1);), "group level lost on the next snapshot");
+
+	/* a block naming port A only: B and D keep their edges and levels */
+	pins(0x08, 0x00, 0x80);
+	snap_all();
+	pins(0x00, 0x01, 0x00);
+	snap_a();
+	hx_check(EDGES(KEY) == 1011, "edge missed by the port A block");
+	hx_check(EDGES(SW) == 110 && EDGES(LIM) == 110, "port not named by the block was updated");
+}
+
+int main()
+{
+	edges();
+	groups();
+	printf("snap: edges, levels and groups ok\n");
+	return 0;
+}
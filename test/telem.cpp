@@ -0,0 +1,115 @@
+/*
+ * telem.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Runs the sys/telem.h encoder on a typical set of channels and
+ * writes the stream and the values for tools/telemdec.py
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#define MAIN
+#define HX_MAIN
+#define HX_WIRE 32768
+#define SERIAL_UARTS 1
+#define TELEM_UART 0
+#define TELEM_CHANNELS 8
+#define TELEM_BATCH 8
+
+#include <math.h>
+#include "dev/serial.h"
+#define u16 uint16_t /* the encoder wraps at 16 bits, as int does on the chip */
+#include "sys/telem.h"
+
+/*
+usage: telem capture.bin values.csv
+1024 samples of 8 channels, a control board's usual mix:
+0-3  ADC inputs, slow sines with +-1 LSB of noise
+4    a PWM duty cycle, stepped every 40 samples
+5    a temperature, +-1 every 256 samples or so
+6    a state, changed every 1000 samples or so
+7    an encoder position, 3..5 counts a sample
+One batch finds the TX ring full of filler (0 bytes, skipped by the
+decoder) and must be dropped whole, the next frame coded so that
+decoding goes on. values.csv is what the decoder has to print.
+*/
+
+static u08 rnd(void)
+{
+	static uint32_t x = 1;
+	x = x * 1103515245 + 12345;
+	return x >> 16;
+}
+
+int main(int argc, char **argv)
+{
+	FILE *csv;
+	static i16 rows[TELEM_BATCH][TELEM_CHANNELS];
+	i16 duty = 300, temp = 250, state = 1, pos = 0;
+	int t, ch, k, frames = 0;
+
+	if (argc < 3 || !(csv = fopen(argv[2], "w")))
+		hx_check(0, "usage: telem capture.bin values.csv");
+	hx.timed = 1;
+	hx.frame = 10 * F_CPU / 115200;
+	hx_reset();
+	UCSR0B = _BV(RXCIE0) | _BV(TXCIE0) | _BV(RXEN0) | _BV(TXEN0);
+
+	for (t = 0; t < 1024; t++) {
+		for (ch = 0; ch < 4; ch++)
+			telem_set(ch, (i16)(512 + 200 * sin(2 * M_PI * t / (700 + 150 * ch))) + rnd() % 3 - 1);
+		if (t % 40 == 0)
+			duty += rnd() % 21 - 10;
+		if (rnd() < 1)
+			temp += rnd() & 1 ? 1 : -1;
+		if (rnd() < 1 && rnd() < 64)
+			state = rnd() % 4;
+		pos += 3 + rnd() % 3;
+		telem_set(4, duty);
+		telem_set(5, temp);
+		telem_set(6, state);
+		telem_set(7, pos);
+		for (ch = 0; ch < TELEM_CHANNELS; ch++)
+			rows[telem_n][ch] = telem_val[ch];
+
+		if (t == 512 - 1)
+			for (k = 0; k < 250; k++)
+				serial_putch(0, 0);
+		u08 seq = telem_seq;
+		u16 skipped = telem_skipped;
+		telem_send();
+		if (telem_n)
+			continue;
+		if (telem_skipped == skipped) {
+			for (k = 0; k < TELEM_BATCH; k++) {
+				fprintf(csv, "%d,%d", seq & 0x7f, k);
+				for (ch = 0; ch < TELEM_CHANNELS; ch++)
+					fprintf(csv, ",%d", rows[k][ch]);
+				fprintf(csv, "\n");
+			}
+			frames++;
+		}
+		hx_drain();
+	}
+	hx_check(telem_skipped == 1 && frames == 1024 / TELEM_BATCH - 1, "full ring not skipped once");
+	hx_check(hx.nwire < HX_WIRE, "capture too long");
+	fclose(csv);
+
+	FILE *f = fopen(argv[1], "wb");
+	if (!f || fwrite(hx.wire, 1, hx.nwire, f) != (size_t)hx.nwire || fclose(f))
+		hx_check(0, "cannot write the capture");
+	printf("telem: %d frames of %d samples, %d bytes, one full ring skipped\n", frames, TELEM_BATCH, hx.nwire - 250);
+	return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * timer.cpp
+ *
+ * Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+ *
+ * Runs sys/timer.h on the Timer2 tick: firing order, periodic timers,
+ * cancel and re-arm from callbacks, tick counter wrap
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+ */
+#define MAIN
+#define HX_MAIN
+
+#include "avrutil.h"
+#define u16 uint16_t /* tick arithmetic wraps at 16 bits, as int does on the chip */
+#include "sys/timer.h"
+
+/*
+tick() runs the Timer2 overflow vector as the chip would, the test calls
+timer_run() in between, once per tick or after several. Each callback
+logs its param and the tick timer_run() was processing; the log must
+match the expected list exactly: nothing early, late, twice or lost.
+*/
+
+/* no UART here, but the model links its vectors */
+void USART0_RX_vect(void) {}
+void USART0_UDRE_vect(void) {}
+void USART0_TX_vect(void) {}
+
+static struct timer t[8];
+static int log_p[64];
+static uint16_t log_t[64];
+static int nlog;
+
+static void tick(int n)
+{
+	while (n--) {
+		hx.in_isr = 1;
+		hx.reg[HX_SREG] &= ~HX_I;
+		TIMER2_OVF_vect();
+		hx.reg[HX_SREG] |= HX_I;
+		hx.in_isr = 0;
+	}
+}
+
+static void run(int n)
+{
+	while (n--) {
+		tick(1);
+		timer_run();
+	}
+}
+
+static void fired(int p)
+{
+	hx_check(nlog < 64, "too many callbacks");
+	log_p[nlog] = p;
+	log_t[nlog++] = timer_now;
+}
+
+static void reset(uint16_t now)
+{
+	int i;
+	hx_reset();
+	tb_ticks = timer_now = now;
+	memset(timer_wheel, 0, sizeof(timer_wheel));
+	for (i = 0; i < 8; i++)
+		timer_init(&t[i], fired, i);
+	nlog = 0;
+}
+
+/* want: pairs of param, tick, ending with -1 */
+static void expect(const int *want, const char *what)
+{
+	int i;
+	for (i = 0; want[2 * i] >= 0; i++)
+		hx_check(i < nlog && log_p[i] == want[2 * i] && log_t[i] == (uint16_t)want[2 * i + 1], what);
+	hx_check(i == nlog, what);
+}
+
+/* expiries in different slots and in later rounds of the same slot,
+   processed once per tick and caught up after a gap */
+static void order()
+{
+	static const int want[] = { 1, 1, 3, 2, 0, 3, 2, 11, 4, 19, -1 };
+	int pass;
+
+	for (pass = 0; pass < 2; pass++) {
+		reset(0);
+		timer_arm(&t[0], 3, 0);
+		timer_arm(&t[1], 1, 0);
+		timer_arm(&t[2], 3 + TIMER_WHEEL_SIZE, 0);
+		timer_arm(&t[3], 2, 0);
+		timer_arm(&t[4], 3 + 2 * TIMER_WHEEL_SIZE, 0);
+		if (pass)
+			tick(25);
+		run(pass ? 1 : 25);
+		expect(want, pass ? "wrong order after catching up" : "wrong order");
+		hx_check(!timer_armed(&t[0]) && !timer_armed(&t[4]), "one-shot still armed");
+	}
+}
+
+/* a periodic timer every 4 ticks from tick 2, and one armed with 0 ticks
+   (runs on the next tick) */
+static void periodic()
+{
+	static const int want[] = { 1, 1, 0, 2, 0, 6, 0, 10, 0, 14, -1 };
+	reset(0);
+	timer_arm(&t[0], 2, 4);
+	timer_arm(&t[1], 0, 0);
+	run(16);
+	expect(want, "periodic timer wrong");
+	hx_check(timer_armed(&t[0]), "periodic timer not armed again");
+}
+
+/* cancelling a timer before it is due, and cancelling twice */
+static void cancel()
+{
+	static const int want[] = { 1, 105, -1 };
+	reset(100);
+	timer_arm(&t[0], 5, 0);
+	timer_arm(&t[1], 5, 0);
+	timer_arm(&t[2], 5, 3);
+	run(3);
+	timer_cancel(&t[0]);
+	timer_cancel(&t[2]);
+	timer_cancel(&t[2]);
+	hx_check(!timer_armed(&t[0]) && !timer_armed(&t[2]) && timer_armed(&t[1]), "armed flag wrong after cancel");
+	run(20);
+	expect(want, "cancelled timer ran");
+}
+
+/*
+Callbacks working on the slot timer_run() is walking: t5, t0, t1 (all
+due at tick 4) and t2 (a round later) share the detached slot, in that
+order. t0 cancels t1 and t2 behind it and arms t3 a round later, into
+the slot being walked; t5 re-arms itself for the next tick up to tick
+8. t6 is periodic every tick from tick 2 and re-arms itself with
+period 5 on its first run.
+*/
+static void slot_fn(int p)
+{
+	fired(p);
+	if (p == 0) {
+		timer_cancel(&t[1]);
+		timer_cancel(&t[2]);
+		timer_arm(&t[3], TIMER_WHEEL_SIZE, 0);
+	}
+	else if (p == 5 && timer_now < 8)
+		timer_arm(&t[5], 1, 0);
+	else if (p == 6 && timer_now == 2)
+		timer_arm(&t[6], 5, 5);
+}
+
+static void from_callbacks()
+{
+	static const int want[] = {
+		6, 2, 5, 4, 0, 4, 5, 5, 5, 6, 5, 7, 6, 7, 5, 8, 6, 12, 3, 12, 6, 17, -1
+	};
+	int i;
+	reset(0);
+	for (i = 0; i < 8; i++)
+		t[i].fn = slot_fn;
+	timer_arm(&t[2], 4 + TIMER_WHEEL_SIZE, 0);
+	timer_arm(&t[1], 4, 0);
+	timer_arm(&t[0], 4, 0);
+	timer_arm(&t[5], 4, 0);
+	timer_arm(&t[6], 2, 1);
+	run(4 + 2 * TIMER_WHEEL_SIZE);
+	timer_cancel(&t[6]);
+	expect(want, "cancel or re-arm from a callback went wrong");
+	hx_check(!timer_armed(&t[1]) && !timer_armed(&t[2]) && !timer_armed(&t[3]) && !timer_armed(&t[5]), "timer left armed");
+}
+
+/* tb_ticks and timer_now wrapping through 0, caught up across it and
+   then tick by tick */
+static void wrap()
+{
+	static const int want[] = { 1, 0xffff, 0, 2, 1, 3, 2, 6, 1, 7, -1 };
+	reset(0xfffd);
+	timer_arm(&t[0], 5, 0);
+	timer_arm(&t[1], 2, 4);
+	timer_arm(&t[2], 9, 0);
+	tick(4);
+	timer_run();
+	run(6);
+	expect(want, "wrong firing across the tick counter wrap");
+}
+
+int main()
+{
+	order();
+	periodic();
+	cancel();
+	from_callbacks();
+	wrap();
+	printf("timer: order, periodic, cancel, callbacks and wrap ok\n");
+	return 0;
+}
@@ -0,0 +1,73 @@
+#
+# avrcap.py
+#
+# Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+#
+# Serial capture and symbol helpers shared by the host decoders
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+
+"""Reading what a node streams, for profsym.py, tracedec.py, telemdec.py
+and latdec.py.
+
+A source is a tty, set to raw 8N1 at the given baud rate and read for
+a number of seconds, or a file holding a raw capture of the stream.
+"""
+
+import os
+import stat
+import subprocess
+import time
+
+
+def chunks(path, seconds, baud):
+    """yields the data as it comes; a tty is read forever if seconds is 0"""
+    if not stat.S_ISCHR(os.stat(path).st_mode):
+        with open(path, 'rb') as f:
+            yield f.read()
+        return
+    import termios
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY | os.O_NONBLOCK)
+    attr = termios.tcgetattr(fd)
+    attr[0] = attr[1] = attr[3] = 0
+    attr[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attr[4] = attr[5] = getattr(termios, 'B%d' % baud)
+    termios.tcsetattr(fd, termios.TCSANOW, attr)
+    end = time.monotonic() + seconds
+    try:
+        while not seconds or time.monotonic() < end:
+            try:
+                yield os.read(fd, 4096)
+            except BlockingIOError:
+                time.sleep(0.01)
+    finally:
+        os.close(fd)
+
+
+def capture(path, seconds, baud):
+    """the whole capture at once"""
+    return b''.join(chunks(path, seconds, baud))
+
+
+def load_funcs(elf, nm):
+    """function address -> name, from the text symbols of elf"""
+    out = subprocess.run([nm, '--defined-only', elf], check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+    funcs = {}
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[1] in 'tTwW':
+            funcs[int(parts[0], 16)] = parts[2]
+    return funcs
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+#
+# bootload.py
+#
+# Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+#
+# Host side of the serial bootloader in boot.c
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+
+"""Upload an Intel HEX image through the boot.c serial bootloader.
+
+usage: bootload.py [-b BAUD] PORT flash.hex
+
+PORT is any tty: a USB serial adapter, or the pty of tools/bootsim.py
+for testing without a board. Reset the board after starting; the tool keeps asking until
+the bootloader answers.
+"""
+
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+
+def crc_xmodem(data, crc=0):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xffff
+    return crc
+
+
+def read_hex(path):
+    image = {}
+    base = 0
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith(':'):
+                continue
+            rec = bytes.fromhex(line[1:])
+            if sum(rec) & 0xff:
+                raise ValueError('bad checksum: ' + line)
+            n, addr, kind = rec[0], (rec[1] << 8) | rec[2], rec[3]
+            data = rec[4:4 + n]
+            if kind == 0:
+                for i, b in enumerate(data):
+                    image[base + addr + i] = b
+            elif kind == 1:
+                break
+            elif kind == 2:
+                base = ((data[0] << 8) | data[1]) << 4
+            elif kind == 4:
+                base = ((data[0] << 8) | data[1]) << 16
+    return image
+
+
+class Port:
+    def __init__(self, path, baud):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        attr = termios.tcgetattr(self.fd)
+        attr[0] = 0                                            # iflag
+        attr[1] = 0                                            # oflag
+        attr[2] = termios.CS8 | termios.CREAD | termios.CLOCAL # cflag
+        attr[3] = 0                                            # lflag
+        speed = getattr(termios, 'B%d' % baud)
+        attr[4] = attr[5] = speed
+        attr[6][termios.VMIN] = 0
+        attr[6][termios.VTIME] = 0
+        termios.tcsetattr(self.fd, termios.TCSANOW, attr)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+
+    def write(self, data):
+        while data:
+            n = os.write(self.fd, data)
+            data = data[n:]
+
+    def read(self, n, timeout):
+        buf = b''
+        end = time.monotonic() + timeout
+        while len(buf) < n:
+            left = end - time.monotonic()
+            if left <= 0 or not select.select([self.fd], [], [], left)[0]:
+                break
+            buf += os.read(self.fd, n - len(buf))
+        return buf
+
+
+def sync(port, timeout):
+    end = time.monotonic() + timeout
+    while time.monotonic() < end:
+        port.write(b'?')
+        reply = port.read(5, 0.1)
+        if len(reply) == 5 and reply[0:1] == b'T':
+            return struct.unpack('<HH', reply[1:])
+        termios.tcflush(port.fd, termios.TCIFLUSH)
+    raise SystemExit('no answer from bootloader')
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('port')
+    ap.add_argument('hexfile')
+    ap.add_argument('-b', '--baud', type=int, default=500000)
+    ap.add_argument('-t', '--timeout', type=float, default=30, help='seconds to wait for the bootloader')
+    ap.add_argument('-n', '--no-run', action='store_true', help='stay in the bootloader when done')
+    args = ap.parse_args()
+
+    image = read_hex(args.hexfile)
+    if not image:
+        raise SystemExit('empty image')
+    port = Port(args.port, args.baud)
+    pagesize, apppages = sync(port, args.timeout)
+
+    npages = max(image) // pagesize + 1
+    if npages > apppages:
+        raise SystemExit('image needs %d pages, application section has %d' % (npages, apppages))
+    flash = bytes(image.get(a, 0xff) for a in range(npages * pagesize))
+
+    start = time.monotonic()
+    written = skipped = 0
+    for n in range(npages):
+        page = flash[n * pagesize:(n + 1) * pagesize]
+        frame = b'P' + struct.pack('<H', n) + page + struct.pack('<H', crc_xmodem(page))
+        for attempt in range(5):
+            port.write(frame)
+            ack = port.read(1, 1.0)
+            if ack in (b'.', b'='):
+                break
+            termios.tcflush(port.fd, termios.TCIFLUSH)
+        else:
+            raise SystemExit('page %d not accepted (%r)' % (n, ack))
+        if ack == b'.':
+            written += 1
+        else:
+            skipped += 1
+        sys.stderr.write('\rpage %d/%d' % (n + 1, npages))
+    sys.stderr.write('\n')
+
+    port.write(b'C' + struct.pack('<HH', npages, crc_xmodem(flash)))
+    if port.read(1, 5.0) != b'K':
+        raise SystemExit('image crc mismatch')
+    print('%d bytes, %d pages written, %d unchanged, %.2fs' %
+          (len(flash), written, skipped, time.monotonic() - start))
+
+    if not args.no_run:
+        port.write(b'G')
+        if port.read(1, 1.0) != b'G':
+            raise SystemExit('bootloader did not start the application')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+#
+# bootsim.py
+#
+# Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+#
+# Stand-in for the boot.c bootloader on a pseudo terminal
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+
+"""Answer the boot.c protocol on a pty, to try tools/bootload.py without a board.
+
+usage: bootsim.py [--pagesize N] [--app-pages N] [--gap-ms MS]
+                  [--drop K ...] [-o flash.bin]
+
+Prints the pty path, then serves until the application is started
+(exit status 0) or interrupted. It follows boot.c: page CRC and range
+checks, '=' for identical pages, the BOOT_GAP_MS timeout that drops a
+frame missing a byte, and 'G' only after a passing 'C'. --drop K loses
+the K-th byte received (counted from 0, repeatable), as a noisy line
+would; the uploader has to recover by resending. -o saves the flash.
+"""
+
+import argparse
+import os
+import pty
+import select
+import struct
+import sys
+import termios
+import tty
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from bootload import crc_xmodem  # noqa: E402
+
+
+class Gap(Exception):
+    pass
+
+
+class Line:
+    def __init__(self, fd, drop):
+        self.fd = fd
+        self.drop = set(drop)
+        self.count = 0
+        self.buf = b''
+
+    def getb(self, timeout):
+        """next byte; None timeout waits forever, else Gap after timeout seconds"""
+        while not self.buf:
+            if not select.select([self.fd], [], [], timeout)[0]:
+                raise Gap()
+            for b in os.read(self.fd, 4096):
+                if self.count not in self.drop:
+                    self.buf += bytes([b])
+                self.count += 1
+        b, self.buf = self.buf[0], self.buf[1:]
+        return b
+
+    def getw(self, timeout):
+        lo = self.getb(timeout)
+        return lo | (self.getb(timeout) << 8)
+
+    def put(self, data):
+        os.write(self.fd, data)
+
+
+def serve(line, flash, pagesize, app_pages, gap):
+    image_ok = False
+    stats = {'written': 0, 'same': 0, 'bad': 0, 'gaps': 0}
+    while True:
+        cmd = line.getb(None)
+        try:
+            if cmd == ord('?'):
+                line.put(b'T' + struct.pack('<HH', pagesize, app_pages))
+            elif cmd == ord('P'):
+                n = line.getw(gap)
+                page = bytes(line.getb(gap) for _ in range(pagesize))
+                crc = line.getw(gap)
+                if crc != crc_xmodem(page) or n >= app_pages:
+                    stats['bad'] += 1
+                    line.put(b'!')
+                elif flash[n * pagesize:(n + 1) * pagesize] == page:
+                    stats['same'] += 1
+                    line.put(b'=')
+                else:
+                    image_ok = False
+                    flash[n * pagesize:(n + 1) * pagesize] = page
+                    stats['written'] += 1
+                    line.put(b'.')
+            elif cmd == ord('C'):
+                n = line.getw(gap)
+                want = line.getw(gap)
+                image_ok = n <= app_pages and crc_xmodem(flash[:n * pagesize]) == want
+                line.put(b'K' if image_ok else b'E')
+            elif cmd == ord('G'):
+                if image_ok:
+                    line.put(b'G')
+                    return stats
+                line.put(b'E')
+        except Gap:
+            stats['gaps'] += 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('--pagesize', type=int, default=128)
+    ap.add_argument('--app-pages', type=int, default=0x7800 // 128)
+    ap.add_argument('--gap-ms', type=float, default=10)
+    ap.add_argument('--drop', type=int, action='append', default=[])
+    ap.add_argument('-o', '--output')
+    args = ap.parse_args()
+
+    master, slave = pty.openpty()
+    tty.setraw(master)
+    tty.setraw(slave, termios.TCSANOW)
+    print(os.ttyname(slave), flush=True)
+
+    flash = bytearray(b'\xff' * (args.pagesize * args.app_pages))
+    stats = serve(Line(master, args.drop), flash, args.pagesize, args.app_pages, args.gap_ms / 1000)
+    sys.stderr.write('started: %d pages written, %d unchanged, %d bad, %d frames timed out\n' %
+                     (stats['written'], stats['same'], stats['bad'], stats['gaps']))
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(flash)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+#
+# latdec.py
+#
+# Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+#
+# Host side of the latency histograms in sys/lat.h
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+
+"""Print the latency histograms sent by lat_dump().
+
+usage: latdec.py [-s SECONDS] [-b BAUD] [--tick-us US] [--uarts N]
+                 [-e main.elf] [--slots FILE] [-v] SOURCE
+
+SOURCE is a tty (read for SECONDS, send the dump command meanwhile) or
+a raw capture file; the last complete dump in it is shown. For each
+slot: the number of samples, the 50/99/99.9% points and the maximum in
+us. Percentiles are bucket upper bounds (at most the maximum), so they
+are pessimistic by up to a factor of 2; the maximum is exact. --tick-us
+is the Timer1 count period, 0.4 for /8 at 20MHz. --uarts must match
+LAT_UARTS. With -e, the DPC behind a maximum is named from the symbols
+of main.elf. --slots names application slots, one "n name" pair per
+line, n counted from LAT_USER. -v prints the buckets too.
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from avrcap import capture, load_funcs  # noqa: E402
+
+
+def parse(data):
+    """returns the slots of the last complete dump, {slot: (max, who, counts)}"""
+    last = None
+    cur = {}
+    i = 0
+    while i < len(data):
+        tag = data[i:i + 1]
+        if tag == b'H' and i + 7 <= len(data):
+            slot, nb = data[i + 1], data[i + 2]
+            end = i + 7 + 2 * nb
+            if nb < 2 or end > len(data):
+                i += 1
+                continue
+            mx = data[i + 3] | (data[i + 4] << 8)
+            who = data[i + 5] | (data[i + 6] << 8)
+            counts = [data[j] | (data[j + 1] << 8) for j in range(i + 7, end, 2)]
+            cur[slot] = (mx, who, counts)
+            i = end
+        elif tag == b'Z' and i + 2 <= len(data):
+            if all(s < data[i + 1] for s in cur):
+                last = cur
+            cur = {}
+            i += 2
+        else:  # out of step, resync
+            i += 1
+    return last
+
+
+def slot_names(uarts, user):
+    names = {0: 'TIMER1_OVF entry', 1: 'TIMER1_OVF run',
+             2: 'TIMER2_OVF entry', 3: 'TIMER2_OVF run',
+             4: 'dpc wait', 5: 'dpc run'}
+    for n in range(uarts):
+        names[6 + 3 * n] = 'USART%d_RX run' % n
+        names[7 + 3 * n] = 'USART%d_UDRE run' % n
+        names[8 + 3 * n] = 'USART%d_TX run' % n
+    base = 6 + 3 * uarts
+    for k, v in user.items():
+        names[base + k] = v
+    return names, base
+
+
+def upper(b, nb):
+    """largest count that falls in bucket b, None for the open last one"""
+    if b == nb - 1:
+        return None
+    return 0 if b == 0 else (1 << b) - 1
+
+
+def percentile(counts, p):
+    total = sum(counts)
+    need = total * p
+    run = 0
+    for b, c in enumerate(counts):
+        run += c
+        if run >= need:
+            return b
+    return len(counts) - 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('source')
+    ap.add_argument('-s', '--seconds', type=float, default=5)
+    ap.add_argument('-b', '--baud', type=int, default=115200)
+    ap.add_argument('--tick-us', type=float, default=0.4)
+    ap.add_argument('--uarts', type=int, default=2)
+    ap.add_argument('-e', '--elf')
+    ap.add_argument('--nm', default='avr-nm')
+    ap.add_argument('--slots')
+    ap.add_argument('-v', '--verbose', action='store_true')
+    args = ap.parse_args()
+
+    user = {}
+    if args.slots:
+        with open(args.slots) as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) == 2:
+                    user[int(parts[0], 0)] = parts[1]
+    names, base = slot_names(args.uarts, user)
+    funcs = load_funcs(args.elf, args.nm) if args.elf else {}
+
+    slots = parse(capture(args.source, args.seconds, args.baud))
+    if slots is None:
+        sys.exit('no complete dump found')
+
+    def us(b, nb, mx):
+        u = upper(b, nb)
+        if u is None or u > mx:  # nothing above the maximum
+            u = mx
+        return '%.1f' % (u * args.tick_us)
+
+    print('%-20s %8s %9s %9s %9s %9s' % ('slot', 'samples', 'p50 us', 'p99 us', 'p99.9 us', 'max us'))
+    for slot in sorted(slots):
+        mx, who, counts = slots[slot]
+        nb = len(counts)
+        name = names.get(slot, 'user%d' % (slot - base) if slot >= base else 'slot%d' % slot)
+        line = '%-20s %8d %9s %9s %9s %9.1f' % (
+            name, sum(counts), us(percentile(counts, 0.5), nb, mx),
+            us(percentile(counts, 0.99), nb, mx), us(percentile(counts, 0.999), nb, mx),
+            mx * args.tick_us)
+        if who:
+            addr = who * 2
+            line += '  max in %s' % funcs.get(addr, '0x%04x' % addr)
+        if max(counts) == 0xffff:
+            line += '  (saturated)'
+        print(line)
+        if args.verbose:
+            for b, c in enumerate(counts):
+                if c:
+                    lo = 0 if b == 0 else 1 << (b - 1)
+                    u = upper(b, nb)
+                    print('%20s %8d  %s..%s' % ('', c, lo, '' if u is None else u))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+#
+# profsym.py
+#
+# Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+#
+# Host side of the sampling profiler in sys/prof.h
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+
+"""Symbolise profiler samples against main.elf.
+
+usage: profsym.py [-e main.elf] [-s SECONDS] [-b BAUD] [--folded] SOURCE
+
+SOURCE is a tty the node streams samples on (read for SECONDS) or a file
+holding a raw capture of that stream. Addresses are mapped to functions
+and source lines with avr-objdump -d -l. --folded prints one
+"function;file:line count" line per location, the input format of
+flamegraph.pl.
+"""
+
+import argparse
+import collections
+import os
+import re
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from avrcap import capture  # noqa: E402
+
+LATE_FLAG = 0x8000
+
+FUNC_RE = re.compile(r'^([0-9a-f]+) <(.+)>:$')
+LINE_RE = re.compile(r'^(/?[^\s:]+):(\d+)')
+INSN_RE = re.compile(r'^\s+([0-9a-f]+):\t')
+
+
+def load_symbols(elf, objdump):
+    """byte address -> (function, file:line) for every instruction"""
+    out = subprocess.run([objdump, '-d', '-l', elf], check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+    table = {}
+    func = line = '?'
+    for text in out.splitlines():
+        m = FUNC_RE.match(text)
+        if m:
+            func = m.group(2)
+            line = '?'
+            continue
+        m = INSN_RE.match(text)
+        if m:
+            table[int(m.group(1), 16)] = (func, line)
+            continue
+        m = LINE_RE.match(text)
+        if m:
+            line = '%s:%s' % (os.path.basename(m.group(1)), m.group(2))
+    return table
+
+
+def parse(data):
+    samples = []
+    lost = 0
+    i = 0
+    while i + 3 <= len(data):
+        tag = data[i:i + 1]
+        word = data[i + 1] | (data[i + 2] << 8)
+        if tag == b'P':
+            samples.append(word)
+            i += 3
+        elif tag == b'L':
+            lost += word
+            i += 3
+        else:  # out of step, resync
+            i += 1
+    return samples, lost
+
+
+def lookup(table, addr):
+    # return addresses point at the next instruction to run, always one we know
+    return table.get(addr, ('?', '0x%04x' % addr))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('source')
+    ap.add_argument('-e', '--elf', default='main.elf')
+    ap.add_argument('-s', '--seconds', type=float, default=10)
+    ap.add_argument('-b', '--baud', type=int, default=115200)
+    ap.add_argument('-n', '--top', type=int, default=20)
+    ap.add_argument('--objdump', default='avr-objdump')
+    ap.add_argument('--folded', action='store_true')
+    args = ap.parse_args()
+
+    table = load_symbols(args.elf, args.objdump)
+    samples, lost = parse(capture(args.source, args.seconds, args.baud))
+    if not samples:
+        raise SystemExit('no samples')
+
+    funcs = collections.Counter()
+    lines = collections.Counter()
+    masked = collections.Counter()
+    for s in samples:
+        func, line = lookup(table, (s & ~LATE_FLAG) * 2)
+        if s & LATE_FLAG:
+            masked[func] += 1
+            func = '[irq masked] ' + func
+        funcs[func] += 1
+        lines[(func, line)] += 1
+
+    if args.folded:
+        for (func, line), n in sorted(lines.items()):
+            print('%s;%s %d' % (func, line, n))
+        return
+
+    total = len(samples)
+    print('%d samples, %d lost, %.1f%% with interrupts masked' %
+          (total, lost, 100.0 * sum(masked.values()) / total))
+    print('\n%7s %6s  function' % ('samples', '%'))
+    for func, n in funcs.most_common(args.top):
+        print('%7d %5.1f%%  %s' % (n, 100.0 * n / total, func))
+    print('\n%7s %6s  line' % ('samples', '%'))
+    for (func, line), n in lines.most_common(args.top):
+        print('%7d %5.1f%%  %s (%s)' % (n, 100.0 * n / total, line, func))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+#
+# telemdec.py
+#
+# Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+#
+# Host side of the telemetry encoder in sys/telem.h
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+
+"""Decode a telemetry stream into CSV.
+
+usage: telemdec.py [-s SECONDS] [-b BAUD] [--stats] SOURCE
+
+SOURCE is a tty the node streams on (read for SECONDS, 0 for ever) or a
+raw capture file. One line per sample: the frame counter, the sample
+in the frame, then the value of every channel. Decoding starts at the
+first key frame and restarts at the next one after a corrupt or missing
+frame. --stats reports samples, errors, bytes per sample and the ratio
+to raw 16 bit values on stderr at the end.
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from avrcap import chunks  # noqa: E402
+
+# channel codes in the map, as in sys/telem.h
+SAME, NIB, VAR = 0, 1, 2
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xff if crc & 0x80 else (crc << 1) & 0xff
+    return crc
+
+
+def varint(data, i):
+    v = shift = 0
+    while True:
+        b = data[i]
+        i += 1
+        v |= (b & 0x7f) << shift
+        shift += 7
+        if not b & 0x80:
+            return v, i
+
+
+def frame(data, i, nch, nb):
+    """decode the frame at data[i] ('T'): (end, key, seq, nch, nb, deltas), None if
+    incomplete; deltas[ch] lists nb steps of a channel that moved.
+    Raises ValueError if it is not a valid frame"""
+    try:
+        hdr = data[i + 1]
+        key = bool(hdr & 0x80)
+        j = i + 2
+        if key:
+            nch, nb = data[j], data[j + 1]
+            j += 2
+        if not nch or nch > 64 or not nb:
+            raise ValueError
+        nmap = (nch + 3) // 4
+        bitmap = data[j:j + nmap]
+        if len(bitmap) < nmap:
+            return None
+        j += nmap
+        deltas = {}
+        for ch in range(nch):
+            code = (bitmap[ch >> 2] >> ((ch & 3) * 2)) & 3
+            if code == SAME:
+                continue
+            if code == NIB:
+                packed = data[j:j + (nb + 1) // 2]
+                if len(packed) < (nb + 1) // 2:
+                    return None
+                j += len(packed)
+                zs = [(packed[k >> 1] >> (4 * (k & 1))) & 0x0f for k in range(nb)]
+            elif code == VAR:
+                zs = []
+                for _ in range(nb):
+                    z, j = varint(data, j)
+                    if z > 0xffff:
+                        raise ValueError
+                    zs.append(z)
+            else:
+                raise ValueError
+            deltas[ch] = [(z >> 1) ^ (0xffff if z & 1 else 0) for z in zs]
+        if crc8(data[i + 1:j]) != data[j]:
+            raise ValueError
+        return j + 1, key, hdr & 0x7f, nch, nb, deltas
+    except IndexError:
+        return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('source')
+    ap.add_argument('-s', '--seconds', type=float, default=0)
+    ap.add_argument('-b', '--baud', type=int, default=115200)
+    ap.add_argument('--stats', action='store_true')
+    args = ap.parse_args()
+
+    data = b''
+    values = None
+    nch = nb = 0
+    seq = None
+    samples = errors = used = 0
+    for chunk in chunks(args.source, args.seconds, args.baud):
+        data += chunk
+        i = 0
+        while True:
+            i = data.find(b'T', i)
+            if i < 0:
+                data = b''
+                break
+            try:
+                r = frame(data, i, nch if values else 0, nb)
+            except ValueError:
+                i += 1  # not a frame start, resync
+                continue
+            if r is None:  # wait for more
+                data = data[i:]
+                break
+            end, key, fseq, fnch, fnb, deltas = r
+            if key:
+                nch, nb = fnch, fnb
+                values = [0] * nch
+            elif values is None or fseq != (seq + 1) & 0x7f:
+                if values is not None:
+                    errors += 1
+                    print('# lost sync before frame %d, waiting for a key frame' % fseq, file=sys.stderr)
+                values = None
+                i = end
+                seq = fseq
+                continue
+            for k in range(nb):
+                for ch, d in deltas.items():
+                    values[ch] = (values[ch] + d[k]) & 0xffff
+                print(','.join([str(fseq), str(k)] + [str(v - 0x10000 if v & 0x8000 else v) for v in values]))
+            samples += nb
+            used += end - i
+            seq = fseq
+            i = end
+        sys.stdout.flush()
+
+    if args.stats:
+        per = used / samples if samples else 0
+        print('%d samples, %d sync losses, %.2f bytes per sample, %d raw: %.2fx' %
+              (samples, errors, per, 2 * nch, 2 * nch / per if per else 0), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+#
+# tracedec.py
+#
+# Copyright (C) 2026 Razvan Tataroiu, razvan784@gmail.com .
+#
+# Host side of the event tracer in sys/trace.h
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301, USA
+
+"""Decode a trace stream into a timeline.
+
+usage: tracedec.py [-s SECONDS] [-b BAUD] [--tick-us US] [-e main.elf]
+                   [--events FILE] SOURCE
+
+SOURCE is a tty the node streams on (read for SECONDS) or a raw capture
+file. Each line shows the time since the first record, the time since
+the previous one, the event and its arguments. --tick-us is the Timer1
+count period, HRT_PRESCALE / F_CPU in us (0.4 for /8 at 20MHz). With -e,
+DPC function addresses are named from the symbols of main.elf. --events
+names application events, one "id name" pair per line, id as counted
+from TRACE_USER (0x40) or absolute when written in hex.
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from avrcap import capture, load_funcs  # noqa: E402
+
+HRT_OVF = 0x01
+DPC_POST = 0x02
+WRITE_PINS = 0x03
+RX, UDRE, TXC = 0x10, 0x14, 0x18
+USER = 0x40
+
+
+def parse(data):
+    """yields (ev, a, b, ts) records and ('lost', n) markers"""
+    i = 0
+    while i < len(data):
+        tag = data[i:i + 1]
+        if tag == b'T' and i + 6 <= len(data):
+            ev, a, b, lo, hi = data[i + 1:i + 6]
+            yield ev, a, b, lo | (hi << 8)
+            i += 6
+        elif tag == b'O' and i + 2 <= len(data):
+            yield 'lost', data[i + 1]
+            i += 2
+        else:  # out of step, resync
+            i += 1
+
+
+def unwrap(records):
+    """extend the 16 bit Timer1 counts using the traced overflows"""
+    base = 0
+    last = None
+    prev_ev = None
+    for rec in records:
+        if rec[0] == 'lost':
+            yield rec
+            continue
+        ev, a, b, ts = rec
+        if last is not None:
+            if ts < last or (ev == HRT_OVF and prev_ev == HRT_OVF):
+                base += 0x10000
+        last = ts
+        prev_ev = ev
+        yield ev, a, b, base + ts
+
+
+def describe(ev, a, b, names, funcs):
+    if ev == HRT_OVF:
+        return 'hrt overflow'
+    if ev == DPC_POST:
+        addr = (a | (b << 8)) * 2
+        return 'dpc_post %s' % funcs.get(addr, '0x%04x' % addr)
+    if ev == WRITE_PINS:
+        return 'write_pins line %d' % (a | (b << 8))
+    if RX <= ev < RX + 4:
+        if b:
+            return 'RX%d ring full, byte left in UDR' % (ev - RX)
+        return 'RX%d 0x%02x' % (ev - RX, a)
+    if UDRE <= ev < UDRE + 4:
+        return 'UDRE%d fed %d' % (ev - UDRE, a)
+    if TXC <= ev < TXC + 4:
+        return 'TXC%d' % (ev - TXC)
+    name = names.get(ev, 'user%d' % (ev - USER) if ev >= USER else 'ev0x%02x' % ev)
+    return '%s %d %d' % (name, a, b)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('source')
+    ap.add_argument('-s', '--seconds', type=float, default=10)
+    ap.add_argument('-b', '--baud', type=int, default=115200)
+    ap.add_argument('--tick-us', type=float, default=0.4)
+    ap.add_argument('-e', '--elf')
+    ap.add_argument('--nm', default='avr-nm')
+    ap.add_argument('--events')
+    args = ap.parse_args()
+
+    names = {}
+    if args.events:
+        with open(args.events) as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) == 2:
+                    key = int(parts[0], 0)
+                    names[key if parts[0].startswith('0x') else USER + key] = parts[1]
+    funcs = load_funcs(args.elf, args.nm) if args.elf else {}
+
+    start = prev = None
+    for rec in unwrap(parse(capture(args.source, args.seconds, args.baud))):
+        if rec[0] == 'lost':
+            print('%12s %10s  -- %d records lost, times below may be off' % ('', '', rec[1]))
+            continue
+        ev, a, b, ts = rec
+        if start is None:
+            start = prev = ts
+        print('%12.1f %+10.1f  %s' % ((ts - start) * args.tick_us, (ts - prev) * args.tick_us,
+                                      describe(ev, a, b, names, funcs)))
+        prev = ts
+
+
+if __name__ == '__main__':
+    main()